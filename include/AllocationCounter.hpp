@@ -0,0 +1,139 @@
+#ifndef ALLOCATIONCOUNTER
+#define ALLOCATIONCOUNTER
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Heap allocation counting, to keep allocations out of the frame loop.
+ *
+ * Global operator new and delete are only hooked in builds made
+ * with COUNT_ALLOCATIONS defined (make COUNT_ALLOCATIONS=1),
+ * otherwise every count stays 0 and nothing is checked.
+ * Counts are kept per thread, each thread only sees its own.
+ * Over-aligned allocations are not counted.
+ */
+class AllocationCounter
+{
+    public:
+
+    struct Counts
+    {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+        uint64_t frees = 0;
+    };
+
+    /**
+     * @brief Allocations made by the calling thread since it started.
+     *
+     * @return Counts
+     */
+    static Counts thread();
+
+    /**
+     * @brief Whether operator new is hooked in this build.
+     *
+     * @return yes/no
+     */
+    static bool enabled();
+};
+
+/**
+ * Allocations of the main thread for each frame, split by phase.
+ * Frames flagged steady, where nothing but the cursor moved,
+ * must not allocate at all, which is checked in debug builds.
+ */
+class FrameAllocations
+{
+    public:
+
+    enum Phase : uint8_t
+    {
+        EVENTS,
+        UPDATE,
+        RENDER,
+        PRESENT,
+        PHASE_COUNT
+    };
+
+    /**
+     * @brief Start counting a frame, in the EVENTS phase.
+     */
+    void beginFrame();
+
+    /**
+     * @brief End the current phase and start another one.
+     *
+     * @param phase
+     */
+    void beginPhase(Phase phase);
+
+    /**
+     * @brief Stop counting the frame.
+     * A steady frame that allocated is logged,
+     * and stops debug builds.
+     *
+     * @param steady Whether the frame should not have allocated.
+     */
+    void endFrame(bool steady);
+
+    /**
+     * @brief Allocations of a phase of the last frame.
+     *
+     * @param phase
+     * @return const AllocationCounter::Counts&
+     */
+    const AllocationCounter::Counts& getLastFrame(Phase phase) { return _lastFrame[phase]; }
+
+    /**
+     * @brief Allocations of the whole last frame.
+     *
+     * @return AllocationCounter::Counts
+     */
+    AllocationCounter::Counts getLastFrameTotal();
+
+    /**
+     * @brief Allocations of every phase since the first frame.
+     *
+     * @param phase
+     * @return const AllocationCounter::Counts&
+     */
+    const AllocationCounter::Counts& getTotal(Phase phase) { return _total[phase]; }
+
+    uint64_t getFrames() { return _frames; }
+    uint64_t getSteadyFrames() { return _steadyFrames; }
+
+    /**
+     * @brief Steady frames that allocated.
+     */
+    uint64_t getViolations() { return _violations; }
+
+    /**
+     * @brief Mean allocations and bytes per frame of each phase, for the log.
+     *
+     * @return std::string
+     */
+    std::string report();
+
+    static std::string phaseName(Phase phase);
+
+    private:
+
+    AllocationCounter::Counts _current[PHASE_COUNT];
+    AllocationCounter::Counts _lastFrame[PHASE_COUNT];
+    AllocationCounter::Counts _total[PHASE_COUNT];
+
+    /**
+     * @brief Thread counts when the current phase began.
+     */
+    AllocationCounter::Counts _phaseStart;
+    Phase _phase = EVENTS;
+
+    uint64_t _frames = 0;
+    uint64_t _steadyFrames = 0;
+    uint64_t _violations = 0;
+};
+
+#endif // ALLOCATIONCOUNTER
@@ -0,0 +1,171 @@
+#ifndef BOARD
+#define BOARD
+
+#include "Node.hpp"
+#include "CardAtlas.hpp"
+#include "CardStore.hpp"
+#include "TweenSet.hpp"
+
+/**
+ * Node displaying the cards of a CardStore.
+ * Cards are not nodes, they are drawn and hit tested
+ * straight from the store arrays.
+ *
+ * Cards are placed in board space, the size of the board node,
+ * and seen through a camera that can pan and zoom.
+ * Only the cards under the camera are drawn.
+ */
+class Board : public Node
+{
+    public:
+
+    Board(
+        Renderer* renderer,
+        std::string name,
+        SDL_Texture* background,
+        SDL_Rect destination
+    );
+
+    ~Board();
+
+    /**
+     * @brief Hit the whole board if it is clickable,
+     * otherwise only hidden cards.
+     *
+     * @param point Point relative to renderer origin.
+     * @return yes/no
+     */
+    virtual bool hitTest(SDL_Point point) override;
+
+    /**
+     * @brief Emit the click event with the card under the point as id,
+     * -1 if the whole board was clicked.
+     *
+     * @param events Queue of the frame.
+     * @param point Point relative to renderer origin.
+     * @param timestamp Time of the click.
+     * @return Ok or not.
+     */
+    virtual bool click(EventQueue& events, SDL_Point point, uint32_t timestamp) override;
+
+    /**
+     * @brief Clicks reaching the board were already filtered by hitTest(),
+     * the clickable flag only makes the whole board catch clicks.
+     *
+     * @return yes/no
+     */
+    virtual bool isClickable() override;
+
+    /**
+     * @brief Return the index of the card under a point.
+     *
+     * @param point Point relative to renderer origin.
+     * @return Index of the card or -1 if none.
+     */
+    int cardAt(SDL_Point point);
+
+    /**
+     * @brief Set the textures used to draw the cards,
+     * indexed by the store texture indices.
+     *
+     * @param atlas Shared with other boards, must outlive the board.
+     */
+    void setAtlas(const CardAtlas* atlas);
+
+    CardStore* getStore() { return &_store; }
+
+    /**
+     * @brief Animations of the cards of the store.
+     */
+    TweenSet* getTweens() { return &_tweens; }
+
+
+    //===============
+    // Camera
+    //===============
+
+    /**
+     * @brief Move the camera by a distance on screen.
+     * The camera never leaves the board.
+     *
+     * @param dx Screen distance, positive to drag the cards right.
+     * @param dy Screen distance, positive to drag the cards down.
+     */
+    void pan(int dx, int dy);
+
+    /**
+     * @brief Zoom while keeping the point under the cursor in place.
+     *
+     * @param point Point relative to renderer origin.
+     * @param factor Above 1 zooms in.
+     */
+    void zoomAt(SDL_Point point, float factor);
+
+    /**
+     * @brief Show the whole board and set how far one can zoom in.
+     *
+     * @param maxZoom 1 to forbid zooming.
+     */
+    void resetCamera(float maxZoom = 1);
+
+    float getZoom() { return _zoom; }
+
+    /**
+     * @brief Give where a rectangle of board space is drawn.
+     *
+     * @param rect Rectangle relative to the board.
+     * @return Rectangle relative to renderer origin.
+     */
+    SDL_Rect boardToScreen(SDL_Rect rect);
+
+    /**
+     * @brief Give the board space point drawn under a screen point.
+     *
+     * @param point Point relative to renderer origin.
+     * @return Point relative to the board.
+     */
+    SDL_Point screenToBoard(SDL_Point point);
+
+    protected:
+
+    /**
+     * @brief Render the background, the children and the cards.
+     *
+     * @return Ok or not.
+     */
+    virtual bool renderTree() override;
+
+    private:
+
+    /**
+     * @brief Render every card under the camera.
+     *
+     * @return Ok or not.
+     */
+    bool renderCards();
+
+    /**
+     * @brief Keep the camera inside the board.
+     */
+    void clampCamera();
+
+    CardStore _store;
+    TweenSet _tweens;
+
+    const CardAtlas* _atlas = nullptr;
+
+    /**
+     * @brief Board space point at the top left corner of the node.
+     */
+    float _cameraX = 0;
+    float _cameraY = 0;
+    float _zoom = 1;
+    float _maxZoom = 1;
+
+    /**
+     * @brief Cards found under the camera, kept to avoid allocations.
+     */
+    std::vector<uint32_t> _visible;
+};
+
+#endif // BOARD
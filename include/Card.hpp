@@ -1,9 +1,15 @@
 #ifndef CARD
 #define CARD
 
-#include "Node.hpp"
+#include "CardStore.hpp"
 
-class Card : public Node
+#include <string>
+
+/**
+ * Lightweight view over a card of a CardStore.
+ * Holds no state of its own, only the store and the index.
+ */
+class Card
 {
     public:
 
@@ -31,12 +37,7 @@ class Card : public Node
         SPECIAL
     };
 
-    Card(  
-        Renderer* renderer,
-        uint32_t suit,
-        uint32_t rank,
-        SDL_Texture* frontTexture
-    );
+    Card(CardStore* store, size_t index);
 
     ~Card();
 
@@ -46,16 +47,8 @@ class Card : public Node
     //===============
 
     /**
-     * @brief Set the Back Texture
-     * rendered when card is not revealed.
-     * 
-     * @param texture Texture to use.
-     */
-    static bool setBackTexture(SDL_Texture* texture);
-
-    /**
-     * @brief Set revealed state and change texture
-     * if needed to reflect the card state.
+     * @brief Set revealed state.
+     * The board renders the front or back texture accordingly.
      * 
      * @param revealed 
      */
@@ -68,48 +61,120 @@ class Card : public Node
     
     static uint32_t getCardHeight() { return _cardHeight; }
     static uint32_t getCardWidth() { return _cardWidth; }
-    static std::string getSuitName(int suit) { return _suits[suit]; }
-    static std::string getRankName(int rank) { return _ranks[rank]; }
+    static constexpr const char* getSuitName(uint32_t suit) { return _suitNames[suit]; }
+    static constexpr const char* getRankName(uint32_t rank) { return _rankNames[rank]; }
+
+    /**
+     * @brief Different faces in a face set,
+     * every rank of every suit except the special one.
+     */
+    static const uint32_t facesPerSet = (DIAMONDS + 1) * SPECIAL;
+
+
+    //===============
+    // Catalog
+    //===============
 
     /**
-     * @brief Give the card key.
-     * A key is an ID unique among different cards
-     * but shared by identical cards.
+     * @brief Packed ID of a card of a face set, special ones included,
+     * dense so that per card tables are flat arrays.
+     */
+    typedef uint8_t Id;
+
+    /**
+     * @brief Cards in a face set, the size of the per card tables.
+     */
+    static constexpr uint32_t cardsPerSet = (DIAMONDS + 1) * (SPECIAL + 1);
+
+    static constexpr Id makeId(uint32_t suit, uint32_t rank) { return suit * (SPECIAL + 1) + rank; }
+    static constexpr uint32_t idSuit(Id id) { return id / (SPECIAL + 1); }
+    static constexpr uint32_t idRank(Id id) { return id % (SPECIAL + 1); }
+    static constexpr Id keyId(uint32_t key) { return makeId(keySuit(key), keyRank(key)); }
+
+    /**
+     * @brief Where a card is on a sprite sheet,
+     * one suit per row and one rank per column.
      * 
-     * @return uint32_t 
+     * @param id 
+     * @return SDL_Rect 
      */
-    uint32_t getKey() { return _rank * 10 + _suit; }
-    uint32_t getSuit() { return _suit; }
-    uint32_t getRank() { return _rank; }
+    static constexpr SDL_Rect atlasRect(Id id)
+    {
+        return { (int)(idRank(id) * _cardWidth), (int)(idSuit(id) * _cardHeight), (int)_cardWidth, (int)_cardHeight };
+    }
 
-    bool getRevealed() { return _revealed; }
+    /**
+     * @brief Give the key of a face.
+     * A key is an ID unique among different faces
+     * but shared by identical cards, whatever deck they come from.
+     * Layout : face set << 8 | suit << 4 | rank.
+     * 
+     * @return uint32_t 
+     */
+    static constexpr uint32_t makeKey(uint32_t suit, uint32_t rank, uint32_t set = 0) { return set << 8 | suit << 4 | rank; }
+    static constexpr uint32_t keySuit(uint32_t key) { return (key >> 4) & 0xf; }
+    static constexpr uint32_t keyRank(uint32_t key) { return key & 0xf; }
+    static constexpr uint32_t keySet(uint32_t key) { return key >> 8; }
 
     /**
-     * @brief Calls setRevealed() to flip the card.
+     * @brief Give the key of the nth face, face sets one after the other.
+     * 
+     * @param face Index below facesPerSet times the number of face sets.
+     * @return uint32_t 
      */
-    void flip();
+    static constexpr uint32_t faceKey(uint32_t face) { return makeKey(face % facesPerSet / SPECIAL, face % SPECIAL, face / facesPerSet); }
 
-    private:
+    /**
+     * @brief Give the index of a card front texture
+     * in the flat texture table of the board, face sets one after the other.
+     * 
+     * @return uint16_t 
+     */
+    static constexpr uint16_t textureIndex(uint32_t suit, uint32_t rank, uint32_t set = 0) { return set * cardsPerSet + makeId(suit, rank); }
+    static constexpr uint16_t keyTextureIndex(uint32_t key) { return textureIndex(keySuit(key), keyRank(key), keySet(key)); }
 
     /**
-     * @brief Generate a name for the node
-     * based on its rank and suit.
+     * @brief Generate a name based on rank, suit and face set.
+     * Only built on demand, for logging.
      * 
      * @return generated name
      */
-    static std::string generateName(uint32_t suit, uint32_t rank);
+    static std::string generateName(uint32_t suit, uint32_t rank, uint32_t set = 0);
+    static std::string keyName(uint32_t key) { return generateName(keySuit(key), keyRank(key), keySet(key)); }
+
+    uint32_t getKey() { return _store->getKey(_index); }
+    uint32_t getSuit() { return keySuit(this->getKey()); }
+    uint32_t getRank() { return keyRank(this->getKey()); }
+    uint32_t getSet() { return keySet(this->getKey()); }
+    size_t getIndex() { return _index; }
+    std::string getName() { return keyName(this->getKey()); }
+
+    bool getRevealed() { return _store->isRevealed(_index); }
+
+    /**
+     * @brief Calls setRevealed() to flip the card.
+     */
+    void flip();
 
-    bool _revealed = true;
-    uint32_t _suit;
-    uint32_t _rank;
-    SDL_Texture* _frontTexture;
+    private:
+
+    CardStore* _store;
+    size_t _index;
 
     static const uint32_t _cardWidth = 69;
     static const uint32_t _cardHeight = 94;
-    static SDL_Texture* _backTexture;
 
-    static std::vector<std::string> _suits;
-    static std::vector<std::string> _ranks;
+    static constexpr const char* _suitNames[DIAMONDS + 1] = {
+        "clubs", "spades", "hearts", "diamonds"
+    };
+
+    static constexpr const char* _rankNames[SPECIAL + 1] = {
+        "ace", "2", "3", "4", "5", "6", "7", "8", "9", "10",
+        "jack", "queen", "king", "special"
+    };
 };
 
+static_assert(Card::cardsPerSet <= 256, "Card IDs must fit in 8 bits.");
+static_assert(Card::atlasRect(Card::makeId(Card::HEARTS, Card::KING)).x == 12 * 69, "Sprite sheets hold one rank per column.");
+
 #endif // CARD
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef CARDATLAS
+#define CARDATLAS
+
+#include "Renderer.hpp"
+
+#include <vector>
+
+/**
+ * Card textures cut from the sprite sheets, shared by every board of the process.
+ * Face sets are added while loading, afterwards the atlas is only read.
+ *
+ * Each level halves the resolution of the previous one, for zoomed out views.
+ * Level 0 is the full resolution. Fronts are indexed by Card::textureIndex().
+ */
+class CardAtlas
+{
+    public:
+
+    CardAtlas(Renderer* renderer);
+
+    /**
+     * @brief Destroy every texture, no board may use the atlas anymore.
+     */
+    ~CardAtlas();
+
+    CardAtlas(const CardAtlas&) = delete;
+    CardAtlas& operator=(const CardAtlas&) = delete;
+
+    /**
+     * @brief Cut a face set from a sprite sheet laid out like the standard one.
+     * The back of the first set is the back of every card.
+     *
+     * @param spriteSheet
+     * @return Ok or not.
+     */
+    bool addFaceSet(SDL_Texture* spriteSheet);
+
+    size_t getFaceSets() const;
+    size_t getLevelCount() const { return _levels.size(); }
+
+    /**
+     * @brief Smallest level still at least as wide as a card drawn on screen.
+     *
+     * @param screenWidth Width of a card on screen.
+     * @return size_t
+     */
+    size_t pickLevel(int screenWidth) const;
+
+    const std::vector<SDL_Texture*>& getFronts(size_t level) const { return _levels[level].fronts; }
+    SDL_Texture* getBack(size_t level) const { return _levels[level].back; }
+
+    private:
+
+    struct Level
+    {
+        int width;
+        int height;
+        std::vector<SDL_Texture*> fronts;
+
+        /**
+         * @brief Back of every card. At level 0 it is one of the fronts,
+         * above it is scaled from the previous level.
+         */
+        SDL_Texture* back;
+    };
+
+    /**
+     * @brief Add halved levels until cards are smaller than anyone could read.
+     *
+     * @return Ok or not.
+     */
+    bool createLevels();
+
+    Renderer* _renderer;
+    std::vector<Level> _levels;
+};
+
+#endif // CARDATLAS
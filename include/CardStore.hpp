@@ -0,0 +1,182 @@
+#ifndef CARDSTORE
+#define CARDSTORE
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+/**
+ * Board state kept as a structure of arrays.
+ * A card is only an index shared by all the arrays,
+ * so that rendering, hit testing and pair matching
+ * walk contiguous memory.
+ *
+ * An optional uniform grid indexes cards by position,
+ * so that hit tests and overlap checks only look at nearby cards
+ * however many cards are on the board.
+ */
+class CardStore
+{
+    public:
+
+    CardStore();
+    ~CardStore();
+
+    /**
+     * @brief Add a card to the store.
+     * The card is added hidden.
+     *
+     * @param key Card key, shared by the two cards of a pair.
+     * @param texture Index of the front texture.
+     * @param rect Card destination, relative to the board.
+     * @return Index of the new card.
+     */
+    size_t add(uint32_t key, uint16_t texture, SDL_Rect rect);
+
+    /**
+     * @brief Mark a card as removed.
+     * Its slot is kept so that other indices stay valid.
+     *
+     * @param index
+     */
+    void remove(size_t index);
+
+    /**
+     * @brief Remove every card.
+     * The grid keeps its size.
+     */
+    void clear();
+
+    /**
+     * @brief Index cards on a uniform grid.
+     * Must be called while the store is empty.
+     * Cards outside the area are indexed in the border cells.
+     *
+     * @param width Width of the indexed area.
+     * @param height Height of the indexed area.
+     * @param cellWidth Cell width, about a card width.
+     * @param cellHeight Cell height, about a card height.
+     */
+    void setGrid(int width, int height, int cellWidth, int cellHeight);
+
+    /**
+     * @brief Reserve room for a number of cards.
+     *
+     * @param count
+     */
+    void reserve(size_t count);
+
+    /**
+     * @brief Return the index of the card under a point.
+     * Removed cards are ignored.
+     *
+     * @param point Point relative to the board.
+     * @return Index of the card or -1 if none.
+     */
+    int cardAt(SDL_Point point);
+
+    /**
+     * @brief Return whether a rectangle overlaps
+     * a card still on the board.
+     *
+     * @param rect Rectangle relative to the board.
+     * @return yes/no
+     */
+    bool overlaps(SDL_Rect rect);
+
+    /**
+     * @brief List the cards still on the board
+     * that intersect a rectangle, each once.
+     *
+     * @param rect Rectangle relative to the board.
+     * @param indices Cleared, then filled with the card indices.
+     */
+    void query(SDL_Rect rect, std::vector<uint32_t>& indices);
+
+
+    //===============
+    // Getters
+    //===============
+
+    size_t size() { return _keys.size(); }
+    size_t remaining() { return _remaining; }
+
+    uint32_t getKey(size_t index) { return _keys[index]; }
+    uint16_t getTexture(size_t index) { return _textures[index]; }
+    SDL_Rect getRect(size_t index) { return _rects[index]; }
+    bool isRevealed(size_t index) { return _revealed[index]; }
+    bool isRemoved(size_t index) { return _removed[index]; }
+
+    const std::vector<SDL_Rect>& getRects() { return _rects; }
+    const std::vector<uint32_t>& getKeys() { return _keys; }
+    const std::vector<uint16_t>& getTextures() { return _textures; }
+    const std::vector<uint8_t>& getRevealed() { return _revealed; }
+    const std::vector<uint8_t>& getRemoved() { return _removed; }
+    const std::vector<float>& getScalesX() { return _scalesX; }
+    const std::vector<uint8_t>& getAlphas() { return _alphas; }
+    const std::vector<uint8_t>& getSwapped() { return _swapped; }
+
+
+    //===============
+    // Setters
+    //===============
+
+    void setRevealed(size_t index, bool revealed) { _revealed[index] = revealed; }
+    void setRect(size_t index, SDL_Rect rect);
+
+    /**
+     * @brief Set how a card is drawn, hit tests ignore it.
+     *
+     * @param index
+     * @param scaleX Width relative to the card rectangle, around its center.
+     * @param alpha Opacity.
+     * @param swapped Draw the other face than the revealed state says,
+     * during the first half of a flip.
+     */
+    void setTransform(size_t index, float scaleX, uint8_t alpha, bool swapped)
+    {
+        _scalesX[index] = scaleX;
+        _alphas[index] = alpha;
+        _swapped[index] = swapped;
+    }
+
+    private:
+
+    /**
+     * @brief Give the range of grid cells covered by a rectangle, clamped to the grid.
+     *
+     * @return Whether the grid is set.
+     */
+    bool cellRange(SDL_Rect rect, int& x0, int& y0, int& x1, int& y1);
+
+    void gridInsert(size_t index);
+    void gridErase(size_t index);
+
+    std::vector<SDL_Rect> _rects;
+    std::vector<uint32_t> _keys;
+    std::vector<uint16_t> _textures;
+    std::vector<uint8_t> _revealed;
+    std::vector<uint8_t> _removed;
+
+    /**
+     * @brief Drawing transforms, written by the animations.
+     */
+    std::vector<float> _scalesX;
+    std::vector<uint8_t> _alphas;
+    std::vector<uint8_t> _swapped;
+
+    /**
+     * @brief Number of cards not removed yet.
+     */
+    size_t _remaining = 0;
+
+    /**
+     * @brief Indices of the cards touching each cell, row by row.
+     */
+    std::vector<std::vector<uint32_t>> _cells;
+    int _gridColumns = 0;
+    int _gridRows = 0;
+    int _cellWidth = 0;
+    int _cellHeight = 0;
+};
+
+#endif // CARDSTORE
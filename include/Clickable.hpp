@@ -12,15 +12,20 @@ class Clickable : public IClickable<T>
     Clickable() {}
     virtual ~Clickable() {}
 
-    virtual void setCallback(std::function<bool (T* clicked)> callback) override {
-        _callback = callback;
+    virtual void setClickEvent(Event event) override {
+        _clickEvent = event;
         this->setClickable(true);
     }
 
-    virtual bool click() override {
-        if(_callback && this->isClickable())
-            return _callback((T*)this);
-        return true;
+    virtual bool click(EventQueue& events, SDL_Point point, uint32_t timestamp) override {
+        if(!this->isClickable())
+            return true;
+
+        Event event = _clickEvent;
+        event.source = static_cast<T*>(this);
+        event.point = point;
+        event.timestamp = timestamp;
+        return events.push(event);
     }
 
     virtual void setClickable(bool clickable) override {
@@ -28,14 +33,17 @@ class Clickable : public IClickable<T>
     }
 
     virtual bool isClickable() override {
-        return _clickable && _callback;
+        return _clickable && this->hasClickEvent();
     }
 
     protected:
+    bool hasClickEvent() { return _clickEvent.type != Event::NONE; }
+    const Event& getClickEvent() { return _clickEvent; }
+
     bool _clickable = false;
 
     private:
-    std::function<bool (T*)> _callback;
+    Event _clickEvent;
 };
 
-#endif // CLICKABLE
\ No newline at end of file
+#endif // CLICKABLE
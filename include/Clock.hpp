@@ -0,0 +1,31 @@
+#ifndef CLOCK
+#define CLOCK
+
+#include <SDL2/SDL.h>
+
+#include <cstdint>
+
+/**
+ * Monotonic high resolution clock, built on the SDL performance counter.
+ * SDL_GetTicks() only has milliseconds, too coarse for frame times.
+ */
+namespace Clock
+{
+    /**
+     * @brief Microseconds from an arbitrary origin, never going back.
+     */
+    inline uint64_t now()
+    {
+        static const uint64_t frequency = SDL_GetPerformanceFrequency();
+        uint64_t counter = SDL_GetPerformanceCounter();
+        // Split so that nanosecond counters do not overflow.
+        return counter / frequency * 1000000 + counter % frequency * 1000000 / frequency;
+    }
+
+    inline double toMilliseconds(uint64_t microseconds)
+    {
+        return microseconds / 1000.0;
+    }
+}
+
+#endif // CLOCK
@@ -0,0 +1,125 @@
+#ifndef EVENTQUEUE
+#define EVENTQUEUE
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+
+class Node;
+
+/**
+ * Input event emitted by a node, handled later in the frame.
+ * Plain data, copied into the queue.
+ */
+struct Event
+{
+    enum Type : uint8_t
+    {
+        NONE,
+
+        /**
+         * @brief Click on the board, id is the card under the cursor or -1.
+         */
+        CARD_CLICKED,
+
+        /**
+         * @brief Click on a button, id is the button given by its owner.
+         */
+        BUTTON_PRESSED,
+
+        /**
+         * @brief The hovered node changed, source is nullptr when nothing is hovered.
+         */
+        HOVER
+    };
+
+    Type type = NONE;
+    int32_t id = -1;
+
+    /**
+     * @brief Node the event comes from.
+     */
+    Node* source = nullptr;
+
+    /**
+     * @brief Cursor position relative to renderer origin.
+     */
+    SDL_Point point = { 0, 0 };
+
+    /**
+     * @brief Time of the input, as given by the SDL event.
+     */
+    uint32_t timestamp = 0;
+
+    static Event cardClicked() { return { CARD_CLICKED, -1, nullptr, { 0, 0 }, 0 }; }
+    static Event buttonPressed(int32_t button) { return { BUTTON_PRESSED, button, nullptr, { 0, 0 }, 0 }; }
+    static Event hover(Node* hovered, SDL_Point point) { return { HOVER, -1, hovered, point, 0 }; }
+
+    static const char* typeName(Type type)
+    {
+        if(type == CARD_CLICKED)
+            return "card_clicked";
+        else if(type == BUTTON_PRESSED)
+            return "button_pressed";
+        else if(type == HOVER)
+            return "hover";
+        return "none";
+    }
+};
+
+/**
+ * Events of a frame, emitted while handling input
+ * and consumed in one batch by the update.
+ * Nothing is allocated, events past the capacity are dropped and counted.
+ */
+class EventQueue
+{
+    public:
+
+    /**
+     * @brief Events kept per frame, far more than a frame of input emits.
+     */
+    static constexpr size_t capacity = 64;
+
+    /**
+     * @brief Append an event.
+     *
+     * @param event
+     * @return Whether there was room for it.
+     */
+    bool push(const Event& event)
+    {
+        if(_size == capacity)
+        {
+            ++_dropped;
+            return false;
+        }
+        _events[_size++] = event;
+        return true;
+    }
+
+    /**
+     * @brief Forget the events, once consumed.
+     */
+    void clear() { _size = 0; }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    /**
+     * @brief Events dropped because the queue was full, since the start.
+     */
+    uint64_t getDropped() const { return _dropped; }
+
+    const Event* begin() const { return _events; }
+    const Event* end() const { return _events + _size; }
+
+    private:
+
+    Event _events[capacity];
+    size_t _size = 0;
+    uint64_t _dropped = 0;
+};
+
+#endif // EVENTQUEUE
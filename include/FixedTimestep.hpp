@@ -0,0 +1,73 @@
+#ifndef FIXEDTIMESTEP
+#define FIXEDTIMESTEP
+
+#include <cstdint>
+
+/**
+ * Turns frame times into updates of a fixed duration,
+ * so that the game runs the same whatever the frame rate.
+ *
+ * Frame time accumulates, each update consumes a step of it.
+ * What is left, less than a step, is the interpolation alpha
+ * for drawing between the last two updates.
+ */
+class FixedTimestep
+{
+    public:
+
+    /**
+     * @brief 100 updates a second.
+     */
+    static constexpr uint64_t defaultStep = 10000;
+
+    /**
+     * @param step Simulated time of an update, in microseconds.
+     * @param maxFrame Frame time simulated at most, in microseconds.
+     * Beyond it the game slows down instead of updating for seconds to catch up.
+     */
+    FixedTimestep(uint64_t step = defaultStep, uint64_t maxFrame = 250000);
+
+    /**
+     * @brief Start a frame. The first one runs a single update,
+     * nothing is drawn before the game updated once.
+     *
+     * @param now Frame time in microseconds, from Clock::now() or a recording.
+     */
+    void advance(uint64_t now);
+
+    /**
+     * @brief Consume a step of the accumulated time, to be called until false.
+     *
+     * @return Whether an update must run.
+     */
+    bool step();
+
+    /**
+     * @brief Simulated time of the last update, in microseconds.
+     */
+    uint64_t getTime() const { return _time; }
+    uint64_t getStep() const { return _step; }
+
+    /**
+     * @brief Part of a step elapsed since the last update, from 0 to 1.
+     */
+    float getAlpha() const { return (float)_accumulator / _step; }
+
+    /**
+     * @brief Frame time not simulated because of clamping, in microseconds.
+     */
+    uint64_t getDropped() const { return _dropped; }
+
+    private:
+
+    uint64_t _step;
+    uint64_t _maxFrame;
+
+    bool _started = false;
+    uint64_t _previousFrame = 0;
+    uint64_t _accumulator = 0;
+    uint64_t _time = 0;
+    uint64_t _dropped = 0;
+};
+
+#endif // FIXEDTIMESTEP
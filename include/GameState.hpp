@@ -0,0 +1,166 @@
+#ifndef GAMESTATE
+#define GAMESTATE
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * Input of the game rules.
+ */
+struct GameAction
+{
+    enum Type : uint8_t
+    {
+        /**
+         * @brief Reveal the card at index card.
+         */
+        PICK,
+
+        /**
+         * @brief Go on after two cards were revealed.
+         */
+        ACKNOWLEDGE,
+
+        /**
+         * @brief Click on the board, a pick or an acknowledge
+         * depending on the phase the game is in when applied.
+         * The card is noCard if the click missed every card.
+         */
+        CLICK
+    };
+
+    static const uint16_t noCard = UINT16_MAX;
+
+    Type type;
+    uint16_t card;
+
+    static GameAction pick(uint16_t card) { return { PICK, card }; }
+    static GameAction acknowledge() { return { ACKNOWLEDGE, 0 }; }
+    static GameAction click(uint16_t card) { return { CLICK, card }; }
+};
+
+/**
+ * Rules of the memory game.
+ * Plain value type : no SDL, no node, no allocation.
+ * Can be copied freely to simulate or test games.
+ */
+class GameState
+{
+    public:
+
+    /**
+     * @brief Describe the game phase.
+     * Values match the former Memory states.
+     */
+    enum Phase : uint8_t
+    {
+        MENU = 0,
+        NO_CARD_REVEALED = 1,
+        ONE_CARD_REVEALED = 2,
+        NO_PAIR = 3,
+        PAIR_FOUND = 4
+    };
+
+    /**
+     * @brief Pairs in a single standard deck.
+     * Bigger games deal several decks, faces then repeat
+     * and any two cards with the same key make a pair.
+     */
+    static const uint32_t deckPairs = 52;
+
+    static const uint32_t maxPairs = 4096;
+    static const uint32_t maxCards = maxPairs * 2;
+    static const uint32_t maxPlayers = 4;
+
+    /**
+     * @brief Start a new game without any card.
+     * First player is active.
+     * Only the slots of the dealt cards are cleared,
+     * so that small games stay cheap to reset.
+     *
+     * @param players Number of players.
+     * @param pairs Number of pairs that will be dealt.
+     * @return Ok or not.
+     */
+    bool reset(uint32_t players, uint32_t pairs);
+
+    /**
+     * @brief Deal a card.
+     *
+     * @param key Card key, shared by the two cards of a pair.
+     * @return Ok or not.
+     */
+    bool addCard(uint32_t key);
+
+    /**
+     * @brief Apply an action.
+     * Illegal actions leave the state unchanged.
+     *
+     * @param action
+     * @return Whether the action was applied.
+     */
+    bool step(GameAction action);
+
+    /**
+     * @brief Return whether a card can be picked.
+     *
+     * @param card
+     * @return yes/no
+     */
+    bool canPick(uint32_t card) const;
+
+
+    //===============
+    // Getters
+    //===============
+
+    Phase getPhase() const { return _phase; }
+    uint32_t getPlayers() const { return _players; }
+    uint32_t getActivePlayer() const { return _activePlayer; }
+    uint32_t getNextPlayer() const { return (_activePlayer + 1) % _players; }
+    uint32_t getScore(uint32_t player) const { return _scores[player]; }
+    uint32_t getPairs() const { return _pairs; }
+    uint32_t getPairsFound() const { return _pairsFound; }
+    uint32_t getCards() const { return _cards; }
+    uint32_t getTurns() const { return _turns; }
+
+    /**
+     * @brief Return whether every pair was found.
+     */
+    bool isOver() const { return _phase != MENU && _pairsFound == _pairs; }
+
+    uint32_t getKey(uint32_t card) const { return _keys[card]; }
+    bool isRevealed(uint32_t card) const { return _revealed[card]; }
+    bool isRemoved(uint32_t card) const { return _removed[card]; }
+
+    /**
+     * @brief Indices of the revealed cards, -1 if none.
+     */
+    int getFirst() const { return _first; }
+    int getSecond() const { return _second; }
+
+    private:
+
+    void pick(uint32_t card);
+    void acknowledge();
+
+    Phase _phase = MENU;
+    uint8_t _players = 1;
+    uint8_t _activePlayer = 0;
+    uint16_t _pairs = 0;
+    uint16_t _pairsFound = 0;
+    uint16_t _cards = 0;
+    int16_t _first = -1;
+    int16_t _second = -1;
+    uint32_t _turns = 0;
+
+    uint32_t _scores[maxPlayers] = {};
+    uint32_t _keys[maxCards] = {};
+    uint8_t _revealed[maxCards] = {};
+    uint8_t _removed[maxCards] = {};
+};
+
+static_assert(std::is_trivially_copyable<GameState>::value, "GameState must stay trivially copyable.");
+
+#endif // GAMESTATE
@@ -0,0 +1,256 @@
+#ifndef GAMETHREAD
+#define GAMETHREAD
+
+#include "GameState.hpp"
+#include "SpscQueue.hpp"
+#include "TripleBuffer.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Input of the game thread, sent by the main thread.
+ */
+struct GameCommand
+{
+    enum Type : uint8_t
+    {
+        /**
+         * @brief New frame time, runs the game clock.
+         */
+        TICK,
+
+        /**
+         * @brief Start a game without any card.
+         */
+        RESET,
+
+        /**
+         * @brief Deal a card of the game being started.
+         */
+        ADD_CARD,
+
+        /**
+         * @brief Apply a game action.
+         */
+        PLAY,
+
+        /**
+         * @brief Leave the game, back to the menu.
+         */
+        MENU,
+
+        QUIT
+    };
+
+    Type type;
+
+    /**
+     * @brief TICK : whether the game is paused.
+     */
+    bool paused;
+
+    /**
+     * @brief RESET : number of players.
+     */
+    uint8_t players;
+
+    /**
+     * @brief PLAY : action to apply.
+     */
+    GameAction action;
+
+    /**
+     * @brief ADD_CARD : card key.
+     */
+    uint32_t value;
+
+    /**
+     * @brief RESET : number of pairs.
+     */
+    uint32_t pairs;
+
+    /**
+     * @brief TICK and RESET : simulated time, in microseconds.
+     */
+    uint64_t time;
+
+    static GameCommand tick(uint64_t time, bool paused) { return { TICK, paused, 0, {}, 0, 0, time }; }
+    static GameCommand reset(uint8_t players, uint32_t pairs, uint64_t time) { return { RESET, false, players, {}, 0, pairs, time }; }
+    static GameCommand addCard(uint32_t key) { return { ADD_CARD, false, 0, {}, key, 0, 0 }; }
+    static GameCommand play(GameAction action) { return { PLAY, false, 0, action, 0, 0, 0 }; }
+    static GameCommand menu() { return { MENU, false, 0, {}, 0, 0, 0 }; }
+    static GameCommand quit() { return { QUIT, false, 0, {}, 0, 0, 0 }; }
+};
+
+/**
+ * Game rules, game clock and high score saving on their own thread,
+ * so that neither a slow frame nor a disk write delays the other side.
+ *
+ * The main thread sends commands through a lock-free queue
+ * and reads immutable snapshots of the game through a triple buffer.
+ * Nothing here touches SDL.
+ */
+class GameThread
+{
+    public:
+
+    /**
+     * @brief What the main thread mirrors on screen.
+     */
+    struct Snapshot
+    {
+        GameState game;
+
+        /**
+         * @brief Game time, pauses excluded, in microseconds.
+         */
+        uint64_t duration = 0;
+
+        /**
+         * @brief Best time for the pairs of the game, 0 if none.
+         */
+        uint32_t record = 0;
+
+        /**
+         * @brief Commands applied, ignored ones included.
+         */
+        uint64_t processed = 0;
+
+        /**
+         * @brief Changes of the game state, to skip unchanged snapshots.
+         */
+        uint64_t steps = 0;
+
+        /**
+         * @brief RESET and MENU commands applied,
+         * tells snapshots of a previous deal apart.
+         */
+        uint64_t resets = 0;
+    };
+
+    /**
+     * @brief Read the high scores file.
+     *
+     * @param path
+     * @param highScores Filled with the best time for each pair count up to its size, 0 if none.
+     * @return Ok or not, a missing file is ok.
+     */
+    static bool readSave(std::string path, std::vector<uint32_t>& highScores);
+
+    /**
+     * @brief Start the thread.
+     *
+     * @param highScores Best time for each pair count, 0 if none.
+     * @param savePath File the high scores are written to.
+     */
+    GameThread(std::vector<uint32_t> highScores, std::string savePath);
+
+    /**
+     * @brief Apply the commands already sent and stop the thread.
+     */
+    ~GameThread();
+
+    /**
+     * @brief Send a command. Main thread only.
+     * Waits for room if the queue is full, e.g. while dealing thousands of cards.
+     *
+     * @param command
+     */
+    void push(const GameCommand& command);
+
+    /**
+     * @brief Take the newest snapshot. Main thread only.
+     *
+     * @return Whether the snapshot changed.
+     */
+    bool consume();
+
+    /**
+     * @brief Wait until the snapshot reflects every command sent. Main thread only.
+     * Used when the game must be the same whatever the thread timings,
+     * like when recording or replaying.
+     */
+    void waitIdle();
+
+    /**
+     * @brief Commands sent so far, a snapshot reflects a command
+     * once its processed count reaches the count after the push.
+     */
+    uint64_t getPushed() { return _pushed; }
+
+    /**
+     * @brief Last snapshot taken. Main thread only.
+     *
+     * @return const Snapshot&
+     */
+    const Snapshot& getSnapshot() { return _snapshots.front(); }
+
+    /**
+     * @brief Enable or disable writing high scores to disk.
+     *
+     * @param enabled
+     */
+    void setSaveEnabled(bool enabled) { _saveEnabled = enabled; }
+
+    private:
+
+    void run();
+
+    /**
+     * @brief Apply a command to the game.
+     *
+     * @param command
+     * @return Whether the thread must stop.
+     */
+    bool apply(const GameCommand& command);
+
+    void tick(uint64_t time, bool paused);
+    void play(GameAction action);
+    bool save();
+
+    /**
+     * @brief Marks saves holding sparse pair counts,
+     * older saves start directly with the times.
+     */
+    static constexpr char _saveMagic[4] = { 'M', 'H', 'S', '2' };
+
+    /**
+     * @brief Copy the game into a snapshot and hand it over.
+     */
+    void publish();
+
+    /**
+     * @brief Enough for a full deal of the biggest game.
+     */
+    SpscQueue<GameCommand, 16384> _commands;
+    TripleBuffer<Snapshot> _snapshots;
+
+    /**
+     * @brief Commands pushed by the main thread.
+     */
+    uint64_t _pushed = 0;
+
+    /**
+     * @brief Wakes the thread up when it waits for commands.
+     */
+    std::mutex _mutex;
+    std::condition_variable _wakeUp;
+    std::atomic<bool> _sleeping { false };
+
+    std::atomic<bool> _saveEnabled { true };
+
+    // Owned by the game thread.
+    Snapshot _state;
+    uint64_t _previousTick = 0;
+    std::vector<uint32_t> _highScores;
+    std::string _savePath;
+
+    std::thread _thread;
+};
+
+#endif // GAMETHREAD
@@ -1,19 +1,32 @@
 #ifndef ICLICKABLE
 #define ICLICKABLE
 
-#include <functional>
+#include "EventQueue.hpp"
 
 template <class T>
 class IClickable
 {
     public:
-    virtual void setCallback(std::function<bool (T* clicked)>) = 0;
+    /**
+     * @brief Set the event emitted when clicked, and make it clickable.
+     * 
+     * @param event Event template, its source, point and timestamp are filled on click.
+     */
+    virtual void setClickEvent(Event event) = 0;
 
-    virtual bool click() = 0;
+    /**
+     * @brief Emit the click event, if clickable.
+     * 
+     * @param events Queue of the frame.
+     * @param point Cursor position relative to renderer origin.
+     * @param timestamp Time of the click.
+     * @return Ok or not.
+     */
+    virtual bool click(EventQueue& events, SDL_Point point, uint32_t timestamp) = 0;
 
     virtual void setClickable(bool clickable) = 0;
 
     virtual bool isClickable() = 0;
 };
 
-#endif // ICLICKABLE
\ No newline at end of file
+#endif // ICLICKABLE
@@ -0,0 +1,64 @@
+#ifndef LATENCYHISTOGRAM
+#define LATENCYHISTOGRAM
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Histogram of latencies with a millisecond resolution.
+ * Recording never allocates, longer latencies share the last bucket.
+ */
+class LatencyHistogram
+{
+    public:
+
+    /**
+     * @brief Latencies from this many milliseconds on share the last bucket.
+     */
+    static constexpr uint32_t maxMs = 1000;
+
+    /**
+     * @brief Add a latency.
+     *
+     * @param ms
+     */
+    void record(uint32_t ms);
+
+    void clear();
+
+    uint64_t getCount() const { return _count; }
+    uint32_t getMax() const { return _max; }
+    double getMean() const { return _count == 0 ? 0 : _sum / (double)_count; }
+
+    /**
+     * @brief Latency under which a part of the records fall.
+     *
+     * @param part From 0 to 1, e.g. 0.95.
+     * @return Milliseconds, 0 if nothing was recorded.
+     */
+    uint32_t percentile(double part) const;
+
+    /**
+     * @brief Percentiles on one line, for overlays and logs.
+     *
+     * @return std::string
+     */
+    std::string summary() const;
+
+    /**
+     * @brief Write the summary and the non empty buckets as CSV.
+     *
+     * @param path
+     * @return Ok or not.
+     */
+    bool dump(std::string path) const;
+
+    private:
+
+    uint64_t _buckets[maxMs + 1] = {};
+    uint64_t _count = 0;
+    uint64_t _sum = 0;
+    uint32_t _max = 0;
+};
+
+#endif // LATENCYHISTOGRAM
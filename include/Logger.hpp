@@ -2,6 +2,7 @@
 #define LOGGER
 
 #include <string>
+#include <vector>
 
 /**
  * Info level logging.
@@ -32,6 +33,15 @@ void logError(std::string msg);
  */
 void log(std::string level, std::string msg);
 
+/**
+ * @brief Copy the last records logged, oldest first.
+ * Does not wait for a log write in progress, e.g. one that stalls.
+ * 
+ * @param records Filled with the records.
+ * @return Whether the records could be read.
+ */
+bool logRecent(std::vector<std::string>& records);
+
 /**
  * @brief Remove log file if already present.
  * 
@@ -2,17 +2,37 @@
 #define MEMORY
 
 #include "TextField.hpp"
+#include "Board.hpp"
 #include "Card.hpp"
+#include "CardAtlas.hpp"
 #include "MouseHandler.hpp"
 #include "Player.hpp"
+#include "GameState.hpp"
+#include "GameThread.hpp"
+#include "EventQueue.hpp"
 
-#include <map>
+#include <memory>
 
 class Memory : public Node
 {
     public:
 
-    Memory(Renderer* renderer, SDL_Texture* spriteSheet, SDL_Texture* background);
+    /**
+     * @brief Create a game, several can share the window side by side.
+     * 
+     * @param renderer
+     * @param atlas Card textures, shared between games, must outlive the game.
+     * @param background Board background, shared between games.
+     * @param area Part of the window used by the game, empty for the whole window.
+     * @param savePath High scores file, one per game.
+     */
+    Memory(
+        Renderer* renderer,
+        const CardAtlas* atlas,
+        SDL_Texture* background,
+        SDL_Rect area = { 0, 0, 0, 0 },
+        std::string savePath = "high_scores"
+    );
 
     ~Memory();
 
@@ -23,10 +43,110 @@ class Memory : public Node
 
     void update();
     bool getQuit();
+
+    /**
+     * @brief Handle an event of the window.
+     * Every game receives every event, clicks and keys other than
+     * escape are only handled by the game under the cursor.
+     * 
+     * @param event 
+     */
     void eventHandler(SDL_Event event);
 
+    /**
+     * @brief Set the time of the next update, from the fixed timestep.
+     * Every time measure of the game uses it,
+     * so that replays run on the recorded clock.
+     * 
+     * @param time Simulated time, in microseconds.
+     */
+    void setTime(uint64_t time)
+    {
+        _previousTime = _time;
+        _time = time;
+    }
+
+    /**
+     * @brief Show the game between the last update and the next one, before rendering.
+     * 
+     * @param alpha Part of a step elapsed since the last update, from 0 to 1.
+     */
+    void interpolate(float alpha);
+
+    /**
+     * @brief Render the tree, then the hover and active highlights.
+     *
+     * @return Ok or not.
+     */
+    virtual bool render() override;
+
+    /**
+     * @brief Enable or disable writing high scores to disk.
+     * 
+     * @param enabled 
+     */
+    void setSaveEnabled(bool enabled) { _gameThread->setSaveEnabled(enabled); }
+
+    /**
+     * @brief Wait for the game thread every frame,
+     * so that the game does not depend on thread timings.
+     * 
+     * @param lockstep 
+     */
+    void setLockstep(bool lockstep) { _lockstep = lockstep; }
+
+    /**
+     * @brief Measure the time from card clicks to their flip on screen.
+     * Meaningless when replaying, the events carry the recorded clock.
+     * 
+     * @param tracking 
+     */
+    void setLatencyTracking(bool tracking) { _latencyTracking = tracking; }
+
+    /**
+     * @brief Whether nothing but the cursor moved for a few frames,
+     * the board being idle. Such frames must not allocate.
+     * 
+     * @return yes/no
+     */
+    bool isSteady() { return _quietFrames > _framesToSteady; }
+
+    /**
+     * @brief Game as of the last snapshot taken by update().
+     */
+    const GameState& getGame() { return _gameThread->getSnapshot().game; }
+
+    /**
+     * @brief Game time of the last snapshot, in microseconds.
+     */
+    uint64_t getGameDuration() { return _gameThread->getSnapshot().duration; }
+
+    /**
+     * @brief Times from card clicks to their flip on screen, for this game only.
+     * 
+     * @return const LatencyHistogram& 
+     */
+    const LatencyHistogram& getInputLatency() { return _inputLatency; }
+
     private:
 
+    /**
+     * @brief Ids of the BUTTON_PRESSED events.
+     */
+    enum Button : uint8_t
+    {
+        BUTTON_ONE_PLAYER,
+        BUTTON_TWO_PLAYERS,
+        BUTTON_INC_PAIRS,
+        BUTTON_INC_PAIRS_10,
+        BUTTON_DEC_PAIRS,
+        BUTTON_DEC_PAIRS_10,
+        BUTTON_START,
+        BUTTON_NEW_GAME,
+        BUTTON_QUIT,
+        BUTTON_COUNT
+    };
+
     void quit();
 
     Node* createMainMenu();
@@ -39,7 +159,7 @@ class Memory : public Node
      * @param buttonNames Node names for the buttons.
      * @param buttonTexts Text to display on the buttons.
      * @param buttonYFactors Factor to apply on y position.
-     * @param callbacks Callbacks to bind to the buttons.
+     * @param buttons Button ids emitted when the buttons are pressed.
      * @return Menu node, nullptr if failure.
      */
     Node* createMenu(
@@ -47,24 +167,18 @@ class Memory : public Node
         std::vector<std::string> buttonNames,
         std::vector<std::string> buttonTexts,
         std::vector<double> buttonYFactors,
-        std::vector<bool (Memory::*)(Node*)> callbacks
+        std::vector<Button> buttons
     );
 
     /**
-     * @brief Load the cards textures
-     * from the spritesheet.
-     * 
-     * @param spriteSheet
-     * @return Ok or not.
-     */
-    bool loadTextures(SDL_Texture* spriteSheet);
-
-    /**
-     * @brief Return a random card from the deck.
+     * @brief Draw the key of every pair.
+     * Boards bigger than the faces of the atlas repeat them.
+     * Faces are shuffled and dealt without repetition
+     * until every face was used, then reshuffled for the next deck.
      * 
-     * @return Card 
+     * @return One key per pair.
      */
-    Card* randomCard();
+    std::vector<uint32_t> dealKeys();
 
     /**
      * @brief Find a random placement on screen
@@ -78,37 +192,93 @@ class Memory : public Node
      */
     SDL_Rect randomDestination(int w, int h, int maxX, int maxY);
 
+    /**
+     * @brief Place cards on a shuffled grid,
+     * shrinking them until the grid fits on the board.
+     * 
+     * @param cards Number of cards.
+     * @param w Card width, updated.
+     * @param h Card height, updated.
+     * @return One destination per card.
+     */
+    std::vector<SDL_Rect> gridDestinations(uint32_t cards, int& w, int& h);
+
+    /**
+     * @brief Reset the game thread and deal the cards of a new game.
+     * Fewer pairs are dealt if the board has no room for all of them.
+     */
     void createPairs();
-    void prepareCard(Card* card, std::string suffixe);
-    void removeCard(Card* card);
+    void prepareCard(uint32_t key, SDL_Rect destination);
+
+    /**
+     * @brief Fade a card out, the store drops it once faded.
+     *
+     * @param index Card index.
+     */
+    void removeCard(size_t index);
+
+    /**
+     * @brief Mirror a card of the game state on the board.
+     * 
+     * @param index Card index.
+     */
+    void syncCard(int index);
+
+    /**
+     * @brief Mirror scores and active player of the game state
+     * on the player nodes.
+     */
+    void syncPlayers();
+
+    /**
+     * @brief Mirror the last snapshot of the game thread
+     * on the board, players, timer and high scores.
+     */
+    void syncGame();
 
     std::string ticksToString(uint32_t ticks);
     void updateTimer();
     void updateRecord();
 
-    Player* getActivePlayer();
-    Player* getNextPlayer();
 
 
     //====================
-    // State functions
+    // Game rules
     //====================
 
-    void state1(Card* clicked);
-    void state2(Card* clicked);
-    void state3();
-    void state4();
+    /**
+     * @brief Send an action to the game thread,
+     * the view follows once the snapshot comes back.
+     * 
+     * @param action
+     * @return Ok or not.
+     */
+    bool play(GameAction action);
 
 
     //====================
     // Buttons functions
     //====================
 
+    /**
+     * @brief Action of each button, indexed by Button.
+     */
+    static bool (Memory::* const _buttonActions[BUTTON_COUNT])(Node*);
+
     bool setPlayers(int players);
     bool onePlayer(Node* n);
     bool twoPlayers(Node* n);
 
     bool changePairs(int offset);
+
+    /**
+     * @brief Step of the ++ and -- buttons,
+     * bigger on large boards.
+     * 
+     * @param increase 
+     * @return int 
+     */
+    int bigPairsStep(bool increase);
     bool incPairs(Node* n);
     bool incPairs10(Node* n);
     bool decPairs(Node* n);
@@ -137,19 +307,28 @@ class Memory : public Node
     //==========================
 
     void keypress(int keycode);
-    void motion();
-    bool click();
-
-    bool cardCallback(Node* clicked);
-    void buttonCallback(Node* clicked);
 
+    /**
+     * @brief Show or hide the frame and latency statistics.
+     */
+    void toggleStats();
+    void updateStats();
+    void motion();
 
-    //==========================
-    // High scores saving
-    //==========================
+    /**
+     * @brief Let the hovered node emit its click event.
+     * 
+     * @param timestamp Time of the click.
+     * @return Ok or not.
+     */
+    bool click(uint32_t timestamp);
 
-    bool readSave();
-    bool save();
+    /**
+     * @brief Consume the events of the frame, in the order they were emitted.
+     */
+    void handleEvents();
+    void cardClicked(const Event& event);
+    void buttonPressed(const Event& event);
 
 
     //==========================
@@ -160,45 +339,110 @@ class Memory : public Node
     bool _pause = false;
 
     /**
-     * @brief Describe the game state.
-     * 0 = menu
-     * 1 = no card revealed
-     * 2 = one card revealed
-     * 3 = two cards revealed
-     * 4 = pair found
+     * @brief Cursor position taken from the last mouse event.
+     * Synthetic events move it the same way as real ones.
+     */
+    SDL_Point _cursor = { 0, 0 };
+
+    /**
+     * @brief Middle button is held on the board, motions pan the camera.
+     */
+    bool _panning = false;
+
+    /**
+     * @brief Game rules, clock and saves. The board and players only mirror its snapshots.
      */
-    uint32_t _state = 0;
+    std::unique_ptr<GameThread> _gameThread;
+    bool _lockstep = false;
+
+    /**
+     * @brief Games started or left, snapshots of older deals are not mirrored.
+     */
+    uint64_t _resets = 0;
+
+    /**
+     * @brief Snapshot steps already mirrored, game time of the snapshot in microseconds
+     * and whole seconds shown by the timer, in milliseconds.
+     */
+    uint64_t _syncedSteps = 0;
+    uint64_t _gameDuration = 0;
+    uint32_t _shownDuration = 0;
+
+    /**
+     * @brief Events emitted by the nodes since the last update().
+     */
+    EventQueue _events;
+    uint64_t _droppedEvents = 0;
+
+    /**
+     * @brief Card click waiting for the game thread, and the command count
+     * the snapshot must reach to reflect it.
+     */
+    uint32_t _pendingInput = 0;
+    uint64_t _pendingInputCommand = 0;
+    bool _latencyTracking = true;
+    LatencyHistogram _inputLatency;
+
+    TextField* _stats = nullptr;
+    uint64_t _statsUpdateTime = 0;
+
+    /**
+     * @brief Simulated time between two updates of the statistics, in microseconds.
+     */
+    uint64_t _statsPeriod = 500000;
+
+    /**
+     * @brief Input other than cursor motion, or a game change,
+     * was handled since the last rendered frame.
+     */
+    bool _active = true;
+
+    /**
+     * @brief Frames without input nor game change, and how many
+     * are needed for caches and buffers to settle.
+     */
+    uint64_t _quietFrames = 0;
+    uint64_t _framesToSteady = 2;
 
     uint32_t _playersNb = 1;
     int _pairs = 20;
-    int _pairsFound = 0;
 
-    uint8_t _minPairs = 2;
-    uint8_t _maxPairs = 52;
+    int _minPairs = 2;
+    int _maxPairs = GameState::maxPairs;
 
-    uint32_t _gameStartTime = 0;
-    uint32_t _previousTimeChange = 0;
-    uint32_t _gameDuration = 0;
+    /**
+     * @brief Cards are scattered at random while they cover
+     * at most this part of the board, dealt on a grid beyond.
+     */
+    double _maxScatteredCoverage = 0.4;
+
+    /**
+     * @brief Simulated time of the current and previous updates, in microseconds.
+     */
+    uint64_t _time = 0;
+    uint64_t _previousTime = 0;
+
+    /**
+     * @brief Card animations, in microseconds.
+     */
+    uint32_t _flipDuration = 200000;
+    uint32_t _vanishDuration = 300000;
 
     float _boardWidthRel = 0.85;
 
     std::vector<Player*> _players;
 
+    /**
+     * @brief Copy of the game thread's high scores, for the menus.
+     */
     std::vector<uint32_t> _highScores;
-    std::string _savePath = "high_scores";
-
-    typedef std::map<uint8_t, std::map<uint8_t, SDL_Texture*>> TextureSet;
-    TextureSet _textureSet;
-
-    typedef std::map<uint8_t, std::map<uint8_t, Card*>> Deck;
-    Deck _deck;
+    std::string _savePath;
 
-    std::vector<Card*> _pickedCard;
-    std::pair<Card*, Card*> _revealedCards;
+    const CardAtlas* _atlas;
 
     SDL_Texture* _background;
 
-    Node* _board = nullptr;
+    Board* _board = nullptr;
     Node* _gameMenu = nullptr;
     Node* _mainMenu = nullptr;
 
@@ -9,6 +9,13 @@ class MouseHandler
     MouseHandler(SDL_Rect action_area = { 0, 0, 0, 0 });
     ~MouseHandler();
 
+    /**
+     * @brief Hit test a node, after the nodes already subscribed.
+     * A node subscribes to one handler at most, and leaves it when deleted.
+     * 
+     * @param node
+     * @return Ok or not.
+     */
     bool addSubscriber(Node* node);
     bool removeSubscriber(Node* node);
 
@@ -16,32 +23,44 @@ class MouseHandler
     SDL_Rect getActionArea();
 
     /**
-     * @brief Call highlight() on hovered nodes or not.
+     * @brief Let highlight() draw the hovered node or not.
      * 
      * @param highlight 
      */
     void setHighlight(bool highlight);
 
     /**
-     * @brief Read current mouse cursor position
+     * @brief Use the mouse cursor position
      * to determine which element is hovered.
+     * A HOVER event is emitted when it changes.
      * 
+     * @param cursor Cursor position, as given by the last mouse event.
+     * @param events Queue of the frame.
      */
-    void motion();
+    void motion(SDL_Point cursor, EventQueue& events);
 
     /**
-     * @brief Call the hovered node click callback.
+     * @brief Draw the hovered node highlighted, if enabled.
+     * Called once per rendered frame, motion() may run several times.
      * 
      * @return Ok or not.
      */
-    bool click();
+    bool highlight();
+
+    /**
+     * @brief Let the hovered node emit its click event.
+     * 
+     * @param events Queue of the frame.
+     * @param timestamp Time of the click.
+     * @return Ok or not.
+     */
+    bool click(EventQueue& events, uint32_t timestamp);
 
     private:
+    void unlinkSubscriber(Node* node);
     void normalCursor();
     void handCursor();
 
-    SDL_Point getCursorPos();
-
     /**
      * @brief Return whether or not the mouse pointer
      * is in this object action area.
@@ -53,12 +72,21 @@ class MouseHandler
     bool isTargeted();
 
     private:
-    std::vector<Node*> _subscribers;
+    /**
+     * @brief Subscribers linked through their nodes, in subscription order.
+     */
+    Node* _firstSubscriber = nullptr;
+    Node* _lastSubscriber = nullptr;
     Node* _hoveredNode = nullptr;
     SDL_Cursor* _normalCursor;
     SDL_Cursor* _handCursor;
     bool _highlight = false;
 
+    /**
+     * @brief Cursor position given to the last motion() call.
+     */
+    SDL_Point _cursor = { 0, 0 };
+
     /**
      * @brief Area in which this handler should be active.
      */
@@ -7,14 +7,48 @@
 #include "Renderer.hpp"
 #include "Clickable.hpp"
 
+class MouseHandler;
+
 /**
  * Graphic node abstraction.
  * Can hold children.
+ *
+ * Children are owned by their parent and linked through their siblings,
+ * adding and removing one is O(1). A deleted node leaves its parent
+ * and its mouse handler by itself.
  */
 class Node : public Clickable<Node>
 {
     public:
 
+    /**
+     * @brief Children in insertion order, for range-based for loops.
+     * The current child must not be removed while iterating.
+     */
+    class Children
+    {
+        public:
+
+        class Iterator
+        {
+            public:
+            Iterator(Node* node) : _node(node) {}
+            Node* operator*() const { return _node; }
+            Iterator& operator++() { _node = _node->_nextSibling; return *this; }
+            bool operator!=(const Iterator& other) const { return _node != other._node; }
+
+            private:
+            Node* _node;
+        };
+
+        Children(Node* first) : _first(first) {}
+        Iterator begin() const { return Iterator(_first); }
+        Iterator end() const { return Iterator(nullptr); }
+
+        private:
+        Node* _first;
+    };
+
     Node(
         Renderer* renderer,
         std::string name,
@@ -33,16 +67,17 @@ class Node : public Clickable<Node>
     //===============
 
     /**
-     * @brief Add a child to the children.
+     * @brief Add a child after the last one.
+     * The parent takes ownership of it.
      * 
-     * @param child
+     * @param child Node without parent.
      * @return Ok or not.
      */
     bool addChild(Node* child);
 
     /**
-     * @brief Remove a child from the vector.
-     * Does not call the child's destructor !
+     * @brief Remove a child from the children.
+     * The child is given back to the caller unless deleted.
      * 
      * @param child
      * @param deleteNode whether the node is deleted (freed) or not.
@@ -66,7 +101,7 @@ class Node : public Clickable<Node>
      * @param recursive Search in the whole tree from this node or not.
      * @return Pointer to the child or nullptr if not found.
      */
-    Node* findChild(std::string name, bool recursive = false);
+    Node* findChild(const std::string& name, bool recursive = false);
 
 
     //===============
@@ -75,18 +110,108 @@ class Node : public Clickable<Node>
 
     /**
      * @brief Render this node and its children.
+     * A cached node blits its cached texture instead,
+     * after rendering the subtree into it if it is dirty.
+     * 
+     * @return Ok or not.
+     */
+    virtual bool render();
+
+    /**
+     * @brief Render the subtree into a texture once
+     * and reuse it until something in the subtree changes.
+     * Meant for rarely changing, non overlapping UI like menus.
+     * 
+     * @param cached 
+     */
+    void setCached(bool cached);
+
+    bool isCached() { return _cached; }
+
+    /**
+     * @brief Tell cached ancestors that this node looks different.
+     * Setters call it, subclasses changing their look by other means must too.
+     */
+    void markDirty();
+
+    /**
+     * @brief Set the renderer layer the node itself is drawn in.
+     * Inside a layer, children come on top of their parent.
+     * 
+     * @param layer Defaults to Renderer::LAYER_UI.
+     */
+    void setLayer(Renderer::Layer layer);
+
+    Renderer::Layer getLayer() { return _layer; }
+
+    protected:
+
+    /**
+     * @brief Render this node and its children, ignoring the cache.
+     * The subtree is drawn from its display list,
+     * flattened again only when something in it changed.
      * 
      * @return Ok or not.
      */
-    bool render();
+    virtual bool renderTree();
+
+    /**
+     * @brief Whether the node only draws its texture and can be flattened
+     * into the display list of its ancestors.
+     * Subclasses overriding renderTree() must clear it.
+     */
+    bool _retained = true;
 
     private:
+
     /**
-     * @brief Render all children.
+     * @brief One drawing of a flattened subtree.
+     */
+    struct DisplayEntry
+    {
+        SDL_Texture* texture;
+
+        /**
+         * @brief Relative to renderer origin.
+         */
+        SDL_Rect rect;
+
+        /**
+         * @brief Drawn over the whole target, the node has no destination.
+         */
+        bool fullTarget;
+
+        Renderer::Layer layer;
+        uint16_t depth;
+
+        /**
+         * @brief Cached or not retained node rendered by itself, or nullptr.
+         */
+        Node* node;
+    };
+
+    /**
+     * @brief Render the subtree into the cache texture if dirty, then blit it.
      * 
      * @return Ok or not.
      */
-    bool renderChildren();
+    bool renderCached();
+
+    /**
+     * @brief Append the drawings of this node and its visible descendants
+     * to a display list, in tree order.
+     * 
+     * @param list 
+     * @param depth Depth of this node in the whole tree.
+     */
+    void flatten(std::vector<DisplayEntry>& list, uint16_t depth);
+
+    /**
+     * @brief Give the depth of this node in the whole tree.
+     * 
+     * @return 0 for a root.
+     */
+    uint16_t getDepth();
 
     public:
 
@@ -96,17 +221,23 @@ class Node : public Clickable<Node>
     //===============
 
     Renderer* getRenderer();
-    std::string getName();
+    const std::string& getName();
     SDL_Rect getDestination();
     int getWidth();
     int getHeight();
     int getX();
     int getY();
     SDL_Texture* getTexture();
-    std::vector<Node*> getChildren();
+    Children getChildren();
+    size_t getChildCount();
     Node* getParent();
     bool isInTree();
 
+    /**
+     * @brief Number of nodes currently alive.
+     */
+    static size_t getCount() { return _count; }
+
     /**
      * @brief Return true if this' destination
      * has width and height at 0.
@@ -150,6 +281,15 @@ class Node : public Clickable<Node>
      */
     virtual bool isClickable() override;
 
+    /**
+     * @brief Return whether a click at this point
+     * should be handled by this node.
+     *
+     * @param point Point relative to renderer origin.
+     * @return yes/no
+     */
+    virtual bool hitTest(SDL_Point point);
+
 
     //===============
     // Setters
@@ -205,10 +345,44 @@ class Node : public Clickable<Node>
     std::string _name;
     SDL_Rect _destination;
     SDL_Texture* _texture;
-    std::vector<Node*> _children;
     Node* _parent = nullptr;
     bool _inTree = false;
     bool _visible = true;
+
+    private:
+    friend class MouseHandler;
+
+    /**
+     * @brief Unlink a child from the children, it keeps its own children.
+     * 
+     * @param child
+     */
+    void unlinkChild(Node* child);
+
+    static size_t _count;
+
+    // Siblings list, owned by the parent.
+    Node* _firstChild = nullptr;
+    Node* _lastChild = nullptr;
+    Node* _previousSibling = nullptr;
+    Node* _nextSibling = nullptr;
+    size_t _childCount = 0;
+
+    // Subscribers list of the mouse handler, see MouseHandler.
+    MouseHandler* _mouseHandler = nullptr;
+    Node* _previousSubscriber = nullptr;
+    Node* _nextSubscriber = nullptr;
+
+    bool _cached = false;
+    bool _dirty = true;
+    SDL_Texture* _cacheTexture = nullptr;
+
+    Renderer::Layer _layer = Renderer::LAYER_UI;
+
+    /**
+     * @brief Subtree flattened by the last renderTree().
+     */
+    std::vector<DisplayEntry> _displayList;
 };
 
 #endif // NODE
@@ -0,0 +1,179 @@
+#ifndef RECORDING
+#define RECORDING
+
+#include "Memory.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Compact binary recording of a session :
+ * deal seed, screen size, then one record per frame
+ * with the frame time in microseconds and the input events given to Memory::eventHandler,
+ * and one record per finished game with its score and duration.
+ *
+ * Numbers are stored as varints, cursor positions as zigzag deltas,
+ * so that an idle frame costs two bytes.
+ */
+namespace Recording
+{
+    /**
+     * @brief Result of a finished game, used to check replays.
+     */
+    struct GameResult
+    {
+        /**
+         * @brief Game time, in microseconds.
+         */
+        uint64_t duration = 0;
+        uint32_t turns = 0;
+        std::vector<uint32_t> scores;
+
+        bool operator==(const GameResult& other) const;
+        std::string toString() const;
+    };
+
+    /**
+     * @brief Read the result of the game if it just finished.
+     *
+     * @param memory
+     * @param wasOver Whether the game was over at the previous frame, updated.
+     * @param result Filled if the game just finished.
+     * @return Whether the game just finished.
+     */
+    bool gameFinished(Memory& memory, bool& wasOver, GameResult& result);
+}
+
+class InputRecorder
+{
+    public:
+
+    InputRecorder();
+    ~InputRecorder();
+
+    /**
+     * @brief Create the file and write the header.
+     *
+     * @param path
+     * @param seed Seed given to srand() before the deal.
+     * @param width Screen width.
+     * @param height Screen height.
+     * @return Ok or not.
+     */
+    bool open(std::string path, uint32_t seed, int width, int height);
+
+    /**
+     * @brief Start a frame.
+     *
+     * @param time Frame time given to the fixed timestep, from Clock::now().
+     */
+    void beginFrame(uint64_t time);
+
+    /**
+     * @brief Record an event given to Memory::eventHandler().
+     * Events ignored by the game are not stored.
+     *
+     * @param event
+     */
+    void event(const SDL_Event& event);
+
+    /**
+     * @brief Write the frame and the result of a game that just finished.
+     *
+     * @param memory
+     */
+    void endFrame(Memory& memory);
+
+    /**
+     * @brief Write the end marker and close the file.
+     */
+    void close();
+
+    private:
+
+    std::ofstream _file;
+    std::vector<uint8_t> _frame;
+    uint32_t _frameEvents = 0;
+    uint64_t _previousTime = 0;
+    SDL_Point _cursor = { 0, 0 };
+    bool _wasOver = false;
+};
+
+class InputReplayer
+{
+    public:
+
+    InputReplayer();
+    ~InputReplayer();
+
+    /**
+     * @brief Open a recording and read its header.
+     *
+     * @param path
+     * @return Ok or not.
+     */
+    bool open(std::string path);
+
+    uint32_t getSeed() { return _seed; }
+    int getWidth() { return _width; }
+    int getHeight() { return _height; }
+
+    /**
+     * @brief Read the next recorded frame and feed its events to the game.
+     * Its time is given by getTime().
+     *
+     * @param memory
+     * @param realtime Wait until the frame's original time or not.
+     * @return Whether there was a frame left.
+     */
+    bool frame(Memory& memory, bool realtime);
+
+    /**
+     * @brief Recorded time of the current frame, in microseconds.
+     */
+    uint64_t getTime() { return _time; }
+
+    /**
+     * @brief Compare the game results with the recorded ones.
+     *
+     * @param memory
+     */
+    void endFrame(Memory& memory);
+
+    /**
+     * @brief Report the replay.
+     *
+     * @return Process exit code, non zero if results differ.
+     */
+    int finish();
+
+    private:
+
+    /**
+     * @brief Compare results available on both sides.
+     */
+    void compare();
+
+    std::ifstream _file;
+    uint32_t _seed = 0;
+    int _width = 0;
+    int _height = 0;
+
+    uint64_t _time = 0;
+    SDL_Point _cursor = { 0, 0 };
+    bool _wasOver = false;
+    bool _ended = false;
+    bool _corrupted = false;
+
+    uint64_t _frames = 0;
+    uint64_t _start = 0;
+    uint64_t _firstTime = 0;
+
+    std::vector<Recording::GameResult> _expected;
+    std::vector<Recording::GameResult> _actual;
+    size_t _checked = 0;
+    size_t _mismatches = 0;
+};
+
+#endif // RECORDING
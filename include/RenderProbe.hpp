@@ -0,0 +1,121 @@
+#ifndef RENDERPROBE
+#define RENDERPROBE
+
+#include <SDL2/SDL.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * Picks the render driver by timing a synthetic board on each of them,
+ * since the accelerated one is not always the fastest.
+ *
+ * The probe runs once per machine, its results are cached on disk
+ * keyed by the video driver, the display and the render drivers available.
+ */
+class RenderProbe
+{
+    public:
+
+    /**
+     * @brief Keeps the driver SDL prefers, without probing.
+     */
+    static constexpr const char* defaultDriver = "default";
+
+    /**
+     * @brief Probes again, even with cached results.
+     */
+    static constexpr const char* probeDriver = "probe";
+
+    /**
+     * @brief File the results are cached in, one backend per line.
+     */
+    static constexpr const char* cachePath = "render_backends.txt";
+
+    struct Result
+    {
+        std::string driver;
+
+        /**
+         * @brief Mean time of a frame, submit and present, negative if the driver failed.
+         */
+        double frameMs;
+    };
+
+    /**
+     * @brief Driver index to create the renderer with.
+     *
+     * @param window Window the renderer is created for, probed on.
+     * @param requested Driver name, defaultDriver, probeDriver, or empty for the cached choice.
+     * @return Index for SDL_CreateRenderer(), -1 lets SDL choose.
+     */
+    static int selectDriver(SDL_Window* window, const std::string& requested);
+
+    /**
+     * @brief Time every render driver on the window.
+     *
+     * @param window
+     * @return One result per driver.
+     */
+    static std::vector<Result> run(SDL_Window* window);
+
+    /**
+     * @brief Identify the machine, results of another one are not reused.
+     */
+    static std::string machineKey();
+
+    /**
+     * @brief Index of a render driver.
+     *
+     * @param name As given by SDL_GetRenderDriverInfo().
+     * @return -1 if not available.
+     */
+    static int driverIndex(const std::string& name);
+
+    private:
+
+    /**
+     * @brief Frames drawn before timing, drivers compile shaders and upload lazily.
+     */
+    static constexpr int _warmupFrames = 5;
+    static constexpr int _timedFrames = 30;
+
+    /**
+     * @brief Time a frame of card copies on a driver.
+     *
+     * @param window
+     * @param index Driver index.
+     * @return Mean frame time in milliseconds, negative on failure.
+     */
+    static double timeDriver(SDL_Window* window, int index);
+
+    /**
+     * @brief Read the cached results of a machine.
+     *
+     * @param key
+     * @param results Filled with the results found.
+     * @return Whether there were results for the machine.
+     */
+    static bool readCache(const std::string& key, std::vector<Result>& results);
+
+    /**
+     * @brief Replace the cached results of a machine, others are kept.
+     *
+     * @param key
+     * @param results
+     * @return Ok or not.
+     */
+    static bool writeCache(const std::string& key, const std::vector<Result>& results);
+
+    /**
+     * @brief Fastest driver available.
+     *
+     * @param results
+     * @return -1 if none works.
+     */
+    static int fastest(const std::vector<Result>& results);
+
+    static void logResults(const std::vector<Result>& results, int chosen);
+};
+
+#endif // RENDERPROBE
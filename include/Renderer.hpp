@@ -3,24 +3,103 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include <functional>
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LatencyHistogram.hpp"
+#include "StartupProfile.hpp"
+#include "ThreadPool.hpp"
 
 /**
  * This class handles everything directly related to rendering on screen.
+ *
+ * Draws are recorded as commands and only submitted by refresh(),
+ * sorted by layer then texture, so that runs of the same texture
+ * go to SDL in one call. Draws of a layer must not overlap each other,
+ * their order inside the layer is not kept.
+ *
+ * When pipelined, a worker thread sorts and batches the draws of a frame
+ * while the previous one is submitted and presented,
+ * which shows every frame one refresh() later.
+ *
+ * Every texture created through the renderer is accounted for by category.
+ * Past the texture budget, the least recently used evictable textures,
+ * like node caches, are destroyed.
  */
 class Renderer
 {
     public:
 
+    /**
+     * @brief Drawing layers, from bottom to top.
+     */
+    enum Layer : uint8_t
+    {
+        LAYER_BACKGROUND,
+        LAYER_CARDS,
+        LAYER_UI,
+        LAYER_OVERLAY
+    };
+
+    /**
+     * @brief Counters of the last submitted frame.
+     */
+    struct FrameStats
+    {
+        /**
+         * @brief Draws recorded.
+         */
+        uint32_t commands = 0;
+
+        /**
+         * @brief Calls made to SDL to draw them.
+         */
+        uint32_t drawCalls = 0;
+
+        /**
+         * @brief Times a different texture was bound.
+         */
+        uint32_t textureSwitches = 0;
+    };
+
+    /**
+     * @brief What a texture is used for, to account texture memory.
+     */
+    enum TextureCategory : uint8_t
+    {
+        TEXTURE_OTHER,
+        TEXTURE_CARDS,
+        TEXTURE_TEXT,
+        TEXTURE_BACKGROUND,
+        TEXTURE_CACHE,
+        TEXTURE_CATEGORY_COUNT
+    };
+
+    /**
+     * @brief Texture memory of a category, estimated from formats and sizes.
+     */
+    struct TextureMemory
+    {
+        size_t textures = 0;
+        size_t bytes = 0;
+        size_t peakBytes = 0;
+    };
+
     Renderer();
     ~Renderer();
 
     /**
      * @brief Renderer initialization.
+     * Only video and events are brought up, other subsystems
+     * cost startup time and nothing uses them.
      * 
+     * @param startup Steps are marked in it if given.
+     * @param driver Render driver, see RenderProbe::selectDriver(). Empty for the cached choice.
      * @return Ok or not.
      */
-    bool init();
+    bool init(StartupProfile* startup = nullptr, const std::string& driver = "");
 
     /**
      * @brief Renderer stop.
@@ -28,10 +107,43 @@ class Renderer
     void stop();
 
     /**
-     * @brief Render current back buffer.
+     * @brief Submit the recorded draws and render current back buffer.
+     * Pipelined, the draws recorded are those of the next refresh().
      */
     void refresh();
 
+    /**
+     * @brief Prepare the draws of a frame on the worker thread
+     * while the previous frame is presented, or not.
+     * 
+     * @param pipelined Defaults to true.
+     */
+    void setPipelined(bool pipelined);
+    bool isPipelined() { return _pipelined; }
+
+    /**
+     * @brief Set the layer of the next draws.
+     * 
+     * @param layer 
+     * @param depth Draws of a deeper node come on top inside the layer.
+     */
+    void setLayer(Layer layer, uint16_t depth = 0);
+
+    Layer getLayer() { return _layer; }
+
+    FrameStats getFrameStats() { return _frameStats; }
+
+    /**
+     * @brief Tell that the draws recorded until the next refresh()
+     * show the effect of an input. Once they are presented,
+     * the time since the input goes to the histogram.
+     * Presenting is as close to the screen as SDL lets us measure.
+     * 
+     * @param histogram Owned by the caller, each game has its own.
+     * @param timestamp Input time, in SDL_GetTicks() milliseconds.
+     */
+    void markInput(LatencyHistogram* histogram, uint32_t timestamp);
+
     /**
      * @brief Clear the screen and fill it with the current drawing color.
      * Ignore viewports.
@@ -57,6 +169,71 @@ class Renderer
      */
     bool setViewport(SDL_Rect* rect = nullptr);
 
+    /**
+     * @brief Restrict the next draws to a rectangle.
+     * 
+     * @param rect Clipping rectangle. If nullptr clipping is disabled.
+     * @return Ok or not.
+     */
+    bool setClipRect(SDL_Rect* rect = nullptr);
+
+    /**
+     * @brief Set the scale applied to every rendering, see SDL_RenderSetScale().
+     * SDL scales mouse events positions the same way,
+     * so hit tests keep working in render coordinates.
+     * 
+     * @param scale 
+     * @return Ok or not.
+     */
+    bool setScale(float scale);
+
+    float getScale() { return _scale; }
+
+    /**
+     * @brief Draw frames into an offscreen target at an internal resolution
+     * adapted to the time spent submitting and presenting them,
+     * and upscale it to the window at present.
+     * Render coordinates stay the same whatever the resolution.
+     * 
+     * @param targetMs Submit and present time to hold, 0 to draw at native resolution.
+     * @param minScale Lowest internal resolution, relative to the window.
+     * @return Ok or not.
+     */
+    bool setDynamicResolution(float targetMs, float minScale = 0.5f);
+
+    /**
+     * @brief Internal resolution relative to the window, 1 at native resolution.
+     */
+    float getResolutionScale() { return _resolution.scale; }
+
+    /**
+     * @brief Area visible on screen, in render coordinates.
+     * Used to cull what would be drawn off screen.
+     * While rendering offscreen, the area the texture stands for.
+     * 
+     * @return SDL_Rect 
+     */
+    SDL_Rect getVisibleArea();
+
+    /**
+     * @brief Redirect rendering into a texture standing for an area of the screen.
+     * Callers keep drawing at screen positions,
+     * what falls in the area lands at the same place in the texture.
+     * Calls can be nested.
+     * 
+     * @param texture Render target texture, the size of the area.
+     * @param area Area relative to renderer origin.
+     * @return Ok or not.
+     */
+    bool beginOffscreen(SDL_Texture* texture, SDL_Rect area);
+
+    /**
+     * @brief Go back to the previous rendering target.
+     * 
+     * @return Ok or not.
+     */
+    bool endOffscreen();
+
     /**
      * @brief Set default font for text rendering.
      * 
@@ -104,17 +281,19 @@ class Renderer
     );
 
     /**
-     * @brief Render a texture.
+     * @brief Record the rendering of a texture on the current layer.
      * 
      * @param texture The texture to render.
      * @param dst Part of the rendering target in which the texture is rendered. Whole rendering target if nullptr.
      * @param portion The portion of the texture to copy to the destination. Entire destination is used if nullptr.
+     * @param alpha Opacity, needs a texture with blending enabled.
      * @return Ok or not.
      */
-    bool renderTexture(SDL_Texture* texture, SDL_Rect* dst = nullptr, SDL_Rect* portion = nullptr);
+    bool renderTexture(SDL_Texture* texture, SDL_Rect* dst = nullptr, SDL_Rect* portion = nullptr, uint8_t alpha = 255);
 
     /**
      * @brief Extract a part of a texture.
+     * The part is accounted in the category of the source.
      * 
      * @param source Texture to extract a part of.
      * @param dst Texture to render to. Will be erased.
@@ -123,6 +302,18 @@ class Renderer
      */
     bool cropTexture(SDL_Texture* src, SDL_Texture*& dst, SDL_Rect* rect);
 
+    /**
+     * @brief Create a resized copy of a texture,
+     * e.g. a lower resolution version drawn when zoomed out.
+     * The copy is accounted in the category of the source.
+     * 
+     * @param src Texture to copy.
+     * @param width 
+     * @param height 
+     * @return texture or nullptr on error.
+     */
+    SDL_Texture* scaleTexture(SDL_Texture* src, int width, int height);
+
     /**
      * @brief Fill _width and _height with values taken from SDL.
      * 
@@ -134,9 +325,10 @@ class Renderer
      * @brief Create a texture from a surface. The surface is freed.
      * 
      * @param surface
+     * @param category What the texture is used for.
      * @return texture or nullptr on error.
      */
-    SDL_Texture* surfaceToTexture(SDL_Surface* surface);
+    SDL_Texture* surfaceToTexture(SDL_Surface* surface, TextureCategory category = TEXTURE_OTHER);
 
     /**
      * @brief Render a texture into another texture.
@@ -154,19 +346,88 @@ class Renderer
      * 
      * @param width 
      * @param height 
+     * @param category What the texture is used for.
      * @return SDL_Texture* nullptr if failure.
      */
-    SDL_Texture* createBlankRenderTarget(int width, int height);
+    SDL_Texture* createBlankRenderTarget(int width, int height, TextureCategory category = TEXTURE_OTHER);
 
     /**
-     * @brief Draw the passed rectangle.
+     * @brief Destroy a texture created by this renderer.
+     * Its memory is released from the accounts right away,
+     * the texture itself once the frames drawing it are presented.
+     * 
+     * @param texture No effect if nullptr or if the renderer is stopped.
+     */
+    void destroyTexture(SDL_Texture* texture);
+
+    /**
+     * @brief Number of textures created by this renderer
+     * and not destroyed yet.
+     */
+    size_t getTextureCount() { return _textures.size(); }
+
+    /**
+     * @brief Set what a texture is used for.
+     * Text textures are already accounted as such, others default to TEXTURE_OTHER.
+     * 
+     * @param texture Texture created by this renderer.
+     * @param category 
+     */
+    void setTextureCategory(SDL_Texture* texture, TextureCategory category);
+
+    /**
+     * @brief Texture memory of a category.
+     * 
+     * @param category 
+     * @return TextureMemory 
+     */
+    TextureMemory getTextureMemory(TextureCategory category) { return _textureMemory[category]; }
+
+    /**
+     * @brief Texture memory of every category.
+     * 
+     * @return TextureMemory 
+     */
+    TextureMemory getTextureMemory() { return _totalTextureMemory; }
+
+    /**
+     * @brief Set the texture memory not to exceed.
+     * Evictable textures are destroyed to stay under it,
+     * a warning is logged when it cannot be.
+     * 
+     * @param bytes 0 for no budget.
+     */
+    void setTextureBudget(size_t bytes);
+
+    size_t getTextureBudget() { return _textureBudget; }
+
+    /**
+     * @brief Let the renderer destroy a texture to stay under the budget.
+     * 
+     * @param texture Texture created by this renderer.
+     * @param onEvict Called once the texture is destroyed,
+     * its owner must forget it and be able to recreate it.
+     */
+    void setEvictable(SDL_Texture* texture, std::function<void()> onEvict);
+
+    /**
+     * @brief Mark an evictable texture as used this frame,
+     * the least recently used ones are evicted first.
+     * Textures used in the last two frames are never evicted.
+     * 
+     * @param texture 
+     */
+    void touchTexture(SDL_Texture* texture);
+
+    /**
+     * @brief Record the drawing of the passed rectangle.
      * 
      * @param rect Rectangle to draw.
      * @param color Defaults to white.
-     * @param restoreTexture Backup and restore current drawing texture or not.
+     * @param layer Defaults to the overlay, above everything else.
      * @return Ok or not.
      */
-    bool drawRectangle(SDL_Rect* rect, SDL_Color color = { 255, 255, 255, 255 }, bool restoreTexture = false);
+    bool drawRectangle(SDL_Rect* rect, SDL_Color color = { 255, 255, 255, 255 }, Layer layer = LAYER_OVERLAY);
     
 
     private:
@@ -181,6 +442,292 @@ class Renderer
      */
     int _height = 0;
 
+    /**
+     * @brief Scale given to SDL_RenderSetScale().
+     */
+    float _scale = 1;
+
+    struct DynamicResolution
+    {
+        /**
+         * @brief Submit and present time to hold, 0 when disabled.
+         */
+        float targetMs = 0;
+        float minScale = 0.5f;
+        float scale = 1;
+
+        /**
+         * @brief Submit and present time, smoothed over the last frames.
+         */
+        double smoothedMs = 0;
+        uint32_t framesSinceChange = 0;
+
+        /**
+         * @brief Window sized, only its top left part is used at lower resolutions.
+         */
+        SDL_Texture* target = nullptr;
+    };
+    DynamicResolution _resolution;
+
+    /**
+     * @brief Frames between resolution changes, for the smoothed time to follow.
+     */
+    static constexpr uint32_t _resolutionSettleFrames = 30;
+
+    /**
+     * @brief Direct the draws of the frame to the scaled target.
+     * 
+     * @return Ok or not.
+     */
+    bool beginScaledFrame();
+
+    /**
+     * @brief Upscale the scaled target to the window.
+     * 
+     * @return Ok or not.
+     */
+    bool endScaledFrame();
+
+    /**
+     * @brief Lower the resolution when frames take longer than the target,
+     * raise it back once they are well below.
+     * 
+     * @param ms Submit and present time of the last frame.
+     */
+    void adaptResolution(double ms);
+
+    struct Offscreen
+    {
+        SDL_Texture* previousTarget;
+        SDL_Rect area;
+
+        /**
+         * @brief First command drawn into the offscreen texture.
+         */
+        size_t firstCommand;
+    };
+
+    struct DrawCommand
+    {
+        Layer layer;
+        uint16_t depth;
+
+        /**
+         * @brief nullptr for rectangles.
+         */
+        SDL_Texture* texture;
+
+        SDL_Rect dst;
+        SDL_Rect portion;
+        bool hasDst;
+        bool hasPortion;
+
+        /**
+         * @brief Texture coordinates of the portion, from 0 to 1.
+         */
+        float u0, v0, u1, v1;
+
+        /**
+         * @brief Recording order, breaks sorting ties.
+         */
+        uint32_t order;
+
+        /**
+         * @brief Rectangles color.
+         */
+        SDL_Color color;
+
+        /**
+         * @brief Textures opacity, kept out of the batch key
+         * so that fading draws still share a batch.
+         */
+        uint8_t alpha;
+
+        SDL_Rect clip;
+        bool hasClip;
+    };
+
+    /**
+     * @brief Run of sorted commands sharing texture, color and clip,
+     * submitted with a single SDL call when possible.
+     */
+    struct Batch
+    {
+        enum Type : uint8_t
+        {
+            RECTANGLES,
+            GEOMETRY,
+            COPIES
+        };
+
+        Type type;
+        SDL_Texture* texture;
+        SDL_Color color;
+        SDL_Rect clip;
+        bool hasClip;
+
+        /**
+         * @brief Range of the batch commands.
+         */
+        uint32_t firstCommand;
+        uint32_t commandCount;
+
+        /**
+         * @brief Range of the batch in the rectangles or the vertices,
+         * its indices count from its first vertex.
+         */
+        uint32_t first;
+        uint32_t count;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+    };
+
+    /**
+     * @brief Oldest input shown by a frame for each histogram,
+     * one per game sharing the window.
+     */
+    struct MarkedInputs
+    {
+        static constexpr size_t capacity = 4;
+
+        struct Input
+        {
+            LatencyHistogram* histogram;
+            uint32_t timestamp;
+        };
+
+        Input inputs[capacity];
+        size_t count = 0;
+
+        void add(LatencyHistogram* histogram, uint32_t timestamp)
+        {
+            for(size_t i = 0 ; i < count ; ++i)
+            {
+                if(inputs[i].histogram == histogram)
+                {
+                    if(timestamp < inputs[i].timestamp)
+                        inputs[i].timestamp = timestamp;
+                    return;
+                }
+            }
+            if(count < capacity)
+                inputs[count++] = { histogram, timestamp };
+        }
+    };
+
+    /**
+     * @brief Draw list of a frame, sorted and batched by prepare().
+     * Plain data, prepared without any SDL call.
+     */
+    struct Frame
+    {
+        std::vector<DrawCommand> commands;
+        std::vector<Batch> batches;
+        std::vector<SDL_Rect> rects;
+        std::vector<SDL_Vertex> vertices;
+        std::vector<int> indices;
+        FrameStats stats;
+
+        MarkedInputs inputs;
+    };
+
+    /**
+     * @brief Draws recorded since the last submit.
+     */
+    std::vector<DrawCommand> _commands;
+
+    /**
+     * @brief Draws the command lists have room for from the start,
+     * so that the first steady frames do not grow them.
+     */
+    static constexpr size_t _reservedCommands = 1024;
+
+    /**
+     * @brief Frame lists, one prepared by the worker while the other is submitted.
+     */
+    Frame _frames[2];
+
+    /**
+     * @brief Frame handed to the worker by the last refresh().
+     */
+    size_t _preparing = 0;
+
+    /**
+     * @brief Draws of offscreen renderings, prepared and submitted right away.
+     */
+    Frame _offscreenFrame;
+
+    bool _pipelined = true;
+    ThreadPool _worker { 1 };
+
+    Layer _layer = LAYER_UI;
+    uint16_t _depth = 0;
+    SDL_Rect _clip = { 0, 0, 0, 0 };
+    bool _hasClip = false;
+
+    /**
+     * @brief Counters of offscreen draws since the last refresh.
+     */
+    FrameStats _stats;
+    FrameStats _frameStats;
+
+    /**
+     * @brief Inputs marked for the draws being recorded.
+     */
+    MarkedInputs _inputs;
+
+    /**
+     * @brief Cull, sort and batch the commands of a frame.
+     * Touches nothing but the frame, safe on the worker thread.
+     * 
+     * @param frame 
+     */
+    static void prepare(Frame& frame);
+
+    /**
+     * @brief Make room in the lists of a frame for a number of draws.
+     * 
+     * @param frame 
+     * @param commands 
+     */
+    static void reserve(Frame& frame, size_t commands);
+
+    /**
+     * @brief Submit a prepared frame into the current rendering target, then empty it.
+     * 
+     * @param frame 
+     * @return Ok or not.
+     */
+    bool submit(Frame& frame);
+
+    /**
+     * @brief Free the destroyed textures no frame left to present draws.
+     * 
+     * @param frame Index of the last presented frame.
+     */
+    void releaseTextures(uint64_t frame);
+
+    /**
+     * @brief Render a texture right away.
+     * 
+     * @return Ok or not.
+     */
+    bool copy(SDL_Texture* texture, SDL_Rect* dst, SDL_Rect* portion, uint8_t alpha = 255);
+
+    /**
+     * @brief Offscreen renderings in progress, innermost last.
+     */
+    std::vector<Offscreen> _offscreens;
+
+    /**
+     * @brief Move a screen rectangle into the current offscreen texture.
+     * 
+     * @param rect Rectangle relative to renderer origin, may be nullptr.
+     * @param moved Storage for the result.
+     * @return rect itself or moved.
+     */
+    SDL_Rect* toTarget(SDL_Rect* rect, SDL_Rect& moved);
+
     /**
      * @brief Window in which the rendering is done.
      */
@@ -195,6 +742,72 @@ class Renderer
      * @brief Font used to render text, if not nullptr.
      */
     TTF_Font* _default_font = nullptr;
+
+    struct TextureInfo
+    {
+        TextureCategory category;
+        uint32_t format;
+        int width;
+        int height;
+        size_t bytes;
+
+        /**
+         * @brief Frame the texture was last touched.
+         */
+        uint64_t lastUsed;
+
+        /**
+         * @brief Set for evictable textures only.
+         */
+        std::function<void()> onEvict;
+    };
+
+    /**
+     * @brief Account a texture just created.
+     * 
+     * @param texture 
+     * @param category 
+     */
+    void registerTexture(SDL_Texture* texture, TextureCategory category);
+
+    /**
+     * @brief Add or remove a texture from the memory of its category.
+     * 
+     * @param info 
+     * @param added 
+     */
+    void accountTexture(const TextureInfo& info, bool added);
+
+    /**
+     * @brief Evict textures until the memory fits in the budget.
+     */
+    void enforceTextureBudget();
+
+    /**
+     * @brief Live textures created through this renderer.
+     */
+    std::unordered_map<SDL_Texture*, TextureInfo> _textures;
+
+    /**
+     * @brief Textures destroyed but still drawn by frames not presented yet,
+     * with the frame index from which they can be freed.
+     */
+    std::vector<std::pair<SDL_Texture*, uint64_t>> _destroyed;
+
+    TextureMemory _textureMemory[TEXTURE_CATEGORY_COUNT];
+    TextureMemory _totalTextureMemory;
+    size_t _textureBudget = 0;
+
+    /**
+     * @brief The budget warning was logged, not logged again
+     * until the memory fits back in.
+     */
+    bool _overBudget = false;
+
+    /**
+     * @brief Frames refreshed so far.
+     */
+    uint64_t _frameIndex = 0;
 };
 
 #endif // RENDERER
\ No newline at end of file
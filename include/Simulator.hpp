@@ -0,0 +1,146 @@
+#ifndef SIMULATOR
+#define SIMULATOR
+
+#include "GameState.hpp"
+
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * How well a simulated player remembers revealed cards.
+ */
+struct PlayerModel
+{
+    /**
+     * @brief Probability to remember a card when it is revealed.
+     */
+    double recall = 1;
+
+    /**
+     * @brief Maximum number of cards remembered at once.
+     * The least recently seen card is forgotten first.
+     */
+    uint32_t capacity = GameState::maxCards;
+};
+
+/**
+ * Monte-Carlo simulation of whole games on the GameState rules,
+ * spread over every core, to get statistics per pair count.
+ */
+class Simulator
+{
+    public:
+
+    struct Options
+    {
+        uint32_t minPairs = 2;
+        uint32_t maxPairs = GameState::deckPairs;
+        uint32_t players = 1;
+        uint64_t games = 10000;
+
+        /**
+         * @brief Worker threads, 0 to use every core.
+         */
+        uint32_t threads = 0;
+
+        uint64_t seed = 0;
+
+        /**
+         * @brief Model of each player.
+         * The last one is reused if there are more players than models.
+         */
+        std::vector<PlayerModel> models;
+
+        /**
+         * @brief Also output the full turns histograms.
+         */
+        bool histogram = false;
+    };
+
+    /**
+     * @brief Statistics for one pair count.
+     */
+    struct Result
+    {
+        uint32_t pairs = 0;
+        uint64_t games = 0;
+
+        /**
+         * @brief Number of games per number of turns to finish.
+         */
+        std::vector<uint64_t> turns;
+
+        std::vector<uint64_t> wins;
+        uint64_t ties = 0;
+
+        double meanTurns() const;
+
+        /**
+         * @brief Smallest number of turns
+         * reached by a ratio of the games.
+         *
+         * @param ratio Between 0 and 1.
+         */
+        uint32_t percentileTurns(double ratio) const;
+
+        /**
+         * @brief Add the games of another result.
+         */
+        void merge(const Result& other);
+    };
+
+    Simulator(Options options);
+    ~Simulator();
+
+    /**
+     * @brief Play every game of the sweep.
+     *
+     * @return One result per pair count.
+     */
+    std::vector<Result> run();
+
+    /**
+     * @brief Write results as text tables.
+     *
+     * @param results
+     * @param out
+     */
+    void print(const std::vector<Result>& results, std::ostream& out);
+
+    /**
+     * @brief Fill options from command line arguments.
+     *
+     * @param args Arguments following the mode switch.
+     * @param options
+     * @return Ok or not.
+     */
+    static bool parseArguments(std::vector<std::string> args, Options& options);
+
+    /**
+     * @brief Entry point of the simulation mode.
+     *
+     * @param args Arguments following the mode switch.
+     * @return Process exit code.
+     */
+    static int main(std::vector<std::string> args);
+
+    private:
+
+    typedef std::mt19937_64 Random;
+
+    /**
+     * @brief Play a batch of games with the same pair count.
+     *
+     * @param pairs
+     * @param games
+     * @param seed Seed of the batch's own generator.
+     * @param result Filled with the batch statistics.
+     */
+    void playGames(uint32_t pairs, uint64_t games, uint64_t seed, Result& result);
+
+    Options _options;
+};
+
+#endif // SIMULATOR
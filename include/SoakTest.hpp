@@ -0,0 +1,175 @@
+#ifndef SOAKTEST
+#define SOAKTEST
+
+#include "Memory.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Bot playing complete games through the real UI paths
+ * by pushing synthetic mouse events in the SDL event queue,
+ * so that they also end up in input recordings.
+ * Tracks frame times, node count, texture count and RSS
+ * and fails if they grow between games.
+ */
+class SoakTest
+{
+    public:
+
+    struct Options
+    {
+        /**
+         * @brief Stop after this many seconds, 0 for no limit.
+         */
+        double duration = 600;
+
+        /**
+         * @brief Stop after this many games, 0 for no limit.
+         */
+        uint64_t games = 0;
+
+        /**
+         * @brief Games played before the reference sample is taken.
+         */
+        uint64_t warmup = 3;
+
+        /**
+         * @brief Tolerated RSS growth over the reference, in kB.
+         */
+        uint64_t maxRssGrowth = 4096;
+
+        /**
+         * @brief Tolerated mean frame time growth, as a factor of the reference.
+         */
+        double maxFrameTimeGrowth = 2;
+
+        uint64_t seed = 0;
+
+        /**
+         * @brief CSV file receiving one sample per game.
+         */
+        std::string output = "soak.csv";
+    };
+
+    /**
+     * @brief Measures taken each time the bot is back on the main menu.
+     */
+    struct Sample
+    {
+        double seconds;
+        uint64_t games;
+        uint64_t frames;
+        double meanFrameMs;
+        double maxFrameMs;
+        size_t nodes;
+        size_t textures;
+
+        /**
+         * @brief Estimated texture memory, text sizes vary from game to game.
+         */
+        size_t textureKb;
+        uint64_t rssKb;
+        double meanDrawCalls;
+        double meanTextureSwitches;
+    };
+
+    SoakTest(Renderer* renderer, Memory* memory, Options options);
+    ~SoakTest();
+
+    /**
+     * @brief Push the events of the next bot action,
+     * they are handled with the events of the next frame.
+     * Quits the game through an escape key press when the test is over.
+     */
+    void frame();
+
+    /**
+     * @brief Write the report.
+     *
+     * @return Process exit code, non zero if something grew.
+     */
+    int finish();
+
+    /**
+     * @brief Fill options from command line arguments.
+     *
+     * @param args Arguments following the mode switch.
+     * @param options
+     * @return Ok or not.
+     */
+    static bool parseArguments(std::vector<std::string> args, Options& options);
+
+    /**
+     * @brief Resident set size of the process in kB, 0 if unknown.
+     */
+    static uint64_t readRssKb();
+
+    private:
+
+    /**
+     * @brief Choose where the bot clicks next.
+     *
+     * @param target Filled with the click position.
+     * @return Whether there is something to click.
+     */
+    bool chooseTarget(SDL_Point& target);
+    bool chooseMenuTarget(SDL_Point& target);
+    bool chooseCardTarget(SDL_Point& target);
+
+    /**
+     * @brief Center of a visible node, by name.
+     */
+    bool nodeCenter(std::string name, SDL_Point& target);
+
+    void injectMotion(SDL_Point target);
+    void injectClick(SDL_Point target);
+    void injectQuit();
+
+    void sample();
+    bool check(const Sample& sample);
+
+    Renderer* _renderer;
+    Memory* _memory;
+    Options _options;
+    std::mt19937_64 _random;
+
+    /**
+     * @brief Cursor was moved on the target, click it next frame.
+     */
+    bool _clickPending = false;
+    SDL_Point _target = { 0, 0 };
+
+    /**
+     * @brief Menu clicks left before starting the next game.
+     */
+    int _menuClicks = -1;
+
+    bool _inGame = false;
+    bool _done = false;
+    bool _failed = false;
+
+    uint64_t _games = 0;
+
+    /**
+     * @brief Clock::now() at the first and last frames, in microseconds.
+     */
+    uint64_t _start = 0;
+    uint64_t _lastFrame = 0;
+
+    uint64_t _frames = 0;
+    double _frameMsSum = 0;
+    double _frameMsMax = 0;
+    uint64_t _drawCallsSum = 0;
+    uint64_t _textureSwitchesSum = 0;
+
+    std::vector<Sample> _samples;
+
+    /**
+     * @brief Index of the sample every later one is compared to, -1 if none yet.
+     */
+    int _reference = -1;
+};
+
+#endif // SOAKTEST
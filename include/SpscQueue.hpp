@@ -0,0 +1,77 @@
+#ifndef SPSCQUEUE
+#define SPSCQUEUE
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Bounded lock-free queue for one producer thread and one consumer thread.
+ * Items are copied in and out of a ring, nothing is allocated after construction.
+ *
+ * @tparam T Item type, meant to be small and trivially copyable.
+ * @tparam Capacity Ring size, a power of two.
+ */
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two.");
+
+    public:
+
+    /**
+     * @brief Append an item. Producer thread only.
+     *
+     * @param item
+     * @return Whether there was room for it.
+     */
+    bool push(const T& item)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if(tail - _head.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        _items[tail & (Capacity - 1)] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest item. Consumer thread only.
+     *
+     * @param item Filled with the item if any.
+     * @return Whether there was an item.
+     */
+    bool pop(T& item)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if(head == _tail.load(std::memory_order_acquire))
+            return false;
+
+        item = _items[head & (Capacity - 1)];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Whether the queue looked empty, from either thread.
+     *
+     * @return yes/no
+     */
+    bool empty() const
+    {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+    private:
+
+    T _items[Capacity];
+
+    /**
+     * @brief Read by the consumer, written by the producer.
+     * Kept on separate cache lines so that the threads do not fight over them.
+     */
+    alignas(64) std::atomic<size_t> _head { 0 };
+    alignas(64) std::atomic<size_t> _tail { 0 };
+};
+
+#endif // SPSCQUEUE
@@ -0,0 +1,57 @@
+#ifndef STARTUPPROFILE
+#define STARTUPPROFILE
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Time spent by each step of the startup, from process start to the first frame.
+ * Measured with the standard clock, so that steps before SDL is up count too.
+ */
+class StartupProfile
+{
+    public:
+
+    /**
+     * @brief Start timing, meant to be the first thing main() does.
+     */
+    StartupProfile();
+
+    /**
+     * @brief End a step, timed from the end of the previous one.
+     *
+     * @param step Name shown in the breakdown.
+     */
+    void mark(const std::string& step);
+
+    /**
+     * @brief Microseconds from the start to the last step.
+     */
+    uint64_t getTotal() const;
+
+    /**
+     * @brief Log every step with its share of the total.
+     *
+     * @param budgetMs Startup time not to exceed, warned about, 0 for none.
+     * @return Whether the startup fit in the budget.
+     */
+    bool log(uint32_t budgetMs) const;
+
+    private:
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Step
+    {
+        std::string name;
+        uint64_t duration;
+    };
+
+    Clock::time_point _start;
+    Clock::time_point _last;
+    std::vector<Step> _steps;
+};
+
+#endif // STARTUPPROFILE
@@ -0,0 +1,98 @@
+#ifndef THREADPOOL
+#define THREADPOOL
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Work-stealing thread pool.
+ * Each worker owns a queue and takes its tasks from the back,
+ * idle workers steal from the front of the other queues.
+ */
+class ThreadPool
+{
+    public:
+
+    /**
+     * @brief Start the workers.
+     *
+     * @param threads Number of workers, 0 to use every core.
+     */
+    ThreadPool(size_t threads = 0);
+
+    /**
+     * @brief Wait for queued tasks and stop the workers.
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Queue a task.
+     * Tasks are spread over the worker queues in turn.
+     *
+     * @param task
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Block until every submitted task is done.
+     */
+    void wait();
+
+    size_t size() { return _threads.size(); }
+
+    private:
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void work(size_t index);
+
+    /**
+     * @brief Take a task from a worker's own queue.
+     *
+     * @param index Worker index.
+     * @param task Filled with the task if any.
+     * @return Whether a task was taken.
+     */
+    bool pop(size_t index, std::function<void()>& task);
+
+    /**
+     * @brief Take a task from another worker's queue.
+     *
+     * @param index Index of the stealing worker.
+     * @param task Filled with the task if any.
+     * @return Whether a task was taken.
+     */
+    bool steal(size_t index, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _threads;
+
+    std::mutex _mutex;
+    std::condition_variable _wakeUp;
+    std::condition_variable _done;
+
+    /**
+     * @brief Tasks waiting in a queue.
+     */
+    std::atomic<size_t> _queued { 0 };
+
+    /**
+     * @brief Tasks queued or running.
+     */
+    std::atomic<size_t> _pending { 0 };
+
+    std::atomic<size_t> _nextQueue { 0 };
+    bool _stop = false;
+};
+
+#endif // THREADPOOL
@@ -0,0 +1,72 @@
+#ifndef TRIPLEBUFFER
+#define TRIPLEBUFFER
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Lock-free handoff of the latest value from one writer thread to one reader thread.
+ * The writer fills its own buffer and publishes it, the reader takes the newest
+ * published one. Neither ever waits for the other, intermediate values may be skipped.
+ *
+ * @tparam T Value type.
+ */
+template<typename T>
+class TripleBuffer
+{
+    public:
+
+    /**
+     * @brief Buffer the writer fills. Writer thread only.
+     * It holds an old value, not the last published one.
+     *
+     * @return T&
+     */
+    T& back() { return _buffers[_back]; }
+
+    /**
+     * @brief Hand the back buffer to the reader. Writer thread only.
+     */
+    void publish()
+    {
+        _back = _middle.exchange(_back | fresh, std::memory_order_acq_rel) & index;
+    }
+
+    /**
+     * @brief Take the newest published value if there is one. Reader thread only.
+     *
+     * @return Whether front() changed.
+     */
+    bool consume()
+    {
+        if(!(_middle.load(std::memory_order_relaxed) & fresh))
+            return false;
+        _front = _middle.exchange(_front, std::memory_order_acq_rel) & index;
+        return true;
+    }
+
+    /**
+     * @brief Last value taken by consume(). Reader thread only.
+     * It stays untouched until the next consume().
+     *
+     * @return const T&
+     */
+    const T& front() const { return _buffers[_front]; }
+
+    private:
+
+    static const uint8_t index = 3;
+    static const uint8_t fresh = 4;
+
+    T _buffers[3] = {};
+    uint8_t _back = 0;
+    uint8_t _front = 2;
+
+    /**
+     * @brief Index of the buffer between both threads,
+     * with the fresh bit while the reader has not taken it.
+     */
+    alignas(64) std::atomic<uint8_t> _middle { 1 };
+};
+
+#endif // TRIPLEBUFFER
@@ -0,0 +1,109 @@
+#ifndef TWEENSET
+#define TWEENSET
+
+#include "CardStore.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Card animations of a board, at most one per card.
+ * Running tweens are kept as parallel arrays, packed at the front,
+ * and all advanced in a single pass. Nothing is allocated once
+ * room for the cards of the deal is reserved.
+ *
+ * Tweens write their transform into the store for rendering,
+ * and apply the change they show once they complete.
+ */
+class TweenSet
+{
+    public:
+
+    enum Type : uint8_t
+    {
+        /**
+         * @brief The card narrows to an edge, then widens on its other face.
+         * The revealed state is already the new one.
+         */
+        FLIP,
+
+        /**
+         * @brief The card fades out, then leaves the store.
+         */
+        VANISH,
+
+        TYPE_COUNT
+    };
+
+    /**
+     * @brief Make room for the cards of a deal, without any tween.
+     *
+     * @param cards
+     */
+    void reserve(size_t cards);
+
+    /**
+     * @brief Stop every tween, e.g. when the store is cleared.
+     */
+    void clear();
+
+    /**
+     * @brief Animate a card, replacing its running tween.
+     * A flip started during a flip turns back from where the card is.
+     *
+     * @param card Index in the store.
+     * @param type
+     * @param duration Microseconds.
+     */
+    void start(uint32_t card, Type type, uint32_t duration);
+
+    /**
+     * @brief Advance every tween and complete the finished ones.
+     *
+     * @param elapsed Microseconds since the previous update.
+     * @param store Cards the tweens animate.
+     */
+    void update(uint64_t elapsed, CardStore& store);
+
+    /**
+     * @brief Write the transforms of the running tweens into the store.
+     *
+     * @param ahead Microseconds past the last update, to draw between updates.
+     * @param store
+     */
+    void apply(uint64_t ahead, CardStore& store);
+
+    /**
+     * @brief Whether a card has a tween of a type running.
+     */
+    bool isRunning(uint32_t card, Type type) const;
+
+    size_t getRunning() const { return _cards.size(); }
+    size_t getRunning(Type type) const { return _running[type]; }
+
+    private:
+
+    /**
+     * @brief Reset the transform of a finished tween and apply its change.
+     */
+    void complete(size_t tween, CardStore& store);
+
+    /**
+     * @brief Move the last tween into a slot, to keep them packed.
+     */
+    void erase(size_t tween);
+
+    std::vector<uint32_t> _cards;
+    std::vector<uint8_t> _types;
+    std::vector<uint32_t> _elapsed;
+    std::vector<uint32_t> _durations;
+
+    /**
+     * @brief Tween of each card of the store, -1 if none.
+     */
+    std::vector<int32_t> _tweenOf;
+
+    size_t _running[TYPE_COUNT] = {};
+};
+
+#endif // TWEENSET
@@ -0,0 +1,150 @@
+#ifndef WATCHDOG
+#define WATCHDOG
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Thread watching the main loop for stalled frames.
+ *
+ * The main loop calls heartbeat() once per frame. When no heartbeat
+ * comes for longer than the threshold, the zones the main thread is in,
+ * the last frame times and the recent log records are written to a dump file,
+ * and the process is aborted if asked to.
+ *
+ * Zones are named scopes of the main thread, see Watchdog::Zone.
+ */
+class Watchdog
+{
+    public:
+
+    struct Options
+    {
+        /**
+         * @brief Frame duration considered a stall, in milliseconds.
+         */
+        uint32_t thresholdMs = 1000;
+
+        /**
+         * @brief Abort once the dump of a stall is written.
+         */
+        bool abort = false;
+
+        /**
+         * @brief File the dumps are appended to.
+         */
+        std::string dumpPath = "stall_dump.txt";
+    };
+
+    /**
+     * @brief Named scope of the main thread, shown in stall dumps.
+     * Meant to live on the stack of the function it names.
+     */
+    class Zone
+    {
+        public:
+
+        /**
+         * @param name Static string, kept by pointer.
+         */
+        Zone(const char* name) { Watchdog::pushZone(name); }
+        ~Zone() { Watchdog::popZone(); }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+    };
+
+    /**
+     * @brief Start the watchdog thread.
+     * The first frame is watched from the first heartbeat.
+     *
+     * @param options
+     */
+    Watchdog(Options options);
+
+    /**
+     * @brief Stop the watchdog thread.
+     */
+    ~Watchdog();
+
+    /**
+     * @brief Tell the watchdog a frame ended. Main thread only.
+     */
+    void heartbeat();
+
+    /**
+     * @brief Stalls dumped so far.
+     */
+    uint64_t getStalls() { return _stalls; }
+
+    /**
+     * @brief Enter a zone. Main thread only, see Zone.
+     *
+     * @param name Static string, kept by pointer.
+     */
+    static void pushZone(const char* name);
+
+    /**
+     * @brief Leave the last zone entered. Main thread only.
+     */
+    static void popZone();
+
+    private:
+
+    typedef std::chrono::steady_clock Clock;
+
+    void run();
+
+    /**
+     * @brief Append the state of the stalled frame to the dump file.
+     *
+     * @param stalledMs Time since the last heartbeat.
+     */
+    void dump(uint64_t stalledMs);
+
+    /**
+     * @brief Microseconds since the watchdog started.
+     */
+    uint64_t now();
+
+    Options _options;
+    Clock::time_point _start;
+
+    /**
+     * @brief Zones deeper than this are counted but not named.
+     */
+    static constexpr size_t maxZones = 32;
+    static std::atomic<const char*> _zones[maxZones];
+    static std::atomic<size_t> _zoneDepth;
+
+    /**
+     * @brief Durations of the last frames in microseconds, as a ring.
+     */
+    static constexpr size_t historySize = 120;
+    std::atomic<uint32_t> _frameTimes[historySize] = {};
+    std::atomic<uint64_t> _frames { 0 };
+
+    /**
+     * @brief Time of the last heartbeat, 0 before the first one.
+     */
+    std::atomic<uint64_t> _lastBeat { 0 };
+
+    /**
+     * @brief Frame already dumped, a stall is dumped only once.
+     */
+    uint64_t _dumpedFrame = UINT64_MAX;
+    std::atomic<uint64_t> _stalls { 0 };
+
+    std::mutex _mutex;
+    std::condition_variable _wakeUp;
+    bool _stop = false;
+
+    std::thread _thread;
+};
+
+#endif // WATCHDOG
@@ -0,0 +1,186 @@
+#include "AllocationCounter.hpp"
+#include "Logger.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+#ifdef COUNT_ALLOCATIONS
+
+namespace
+{
+    // Constant initialized, usable from operator new before any constructor ran.
+    thread_local AllocationCounter::Counts threadCounts;
+}
+
+void* operator new(std::size_t size)
+{
+    ++threadCounts.allocations;
+    threadCounts.bytes += size;
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if(pointer == nullptr)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    ++threadCounts.allocations;
+    threadCounts.bytes += size;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if(pointer != nullptr)
+        ++threadCounts.frees;
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+AllocationCounter::Counts AllocationCounter::thread()
+{
+    return threadCounts;
+}
+
+bool AllocationCounter::enabled()
+{
+    return true;
+}
+
+#else
+
+AllocationCounter::Counts AllocationCounter::thread()
+{
+    return Counts();
+}
+
+bool AllocationCounter::enabled()
+{
+    return false;
+}
+
+#endif // COUNT_ALLOCATIONS
+
+
+//====================
+// Frame allocations
+//====================
+
+void FrameAllocations::beginFrame()
+{
+    for(AllocationCounter::Counts& counts : _current)
+        counts = AllocationCounter::Counts();
+    _phase = EVENTS;
+    _phaseStart = AllocationCounter::thread();
+}
+
+void FrameAllocations::beginPhase(Phase phase)
+{
+    AllocationCounter::Counts now = AllocationCounter::thread();
+    AllocationCounter::Counts& counts = _current[_phase];
+    counts.allocations += now.allocations - _phaseStart.allocations;
+    counts.bytes += now.bytes - _phaseStart.bytes;
+    counts.frees += now.frees - _phaseStart.frees;
+    _phase = phase;
+    _phaseStart = now;
+}
+
+void FrameAllocations::endFrame(bool steady)
+{
+    this->beginPhase(_phase);
+    ++_frames;
+    for(int phase = 0 ; phase < PHASE_COUNT ; ++phase)
+    {
+        _lastFrame[phase] = _current[phase];
+        _total[phase].allocations += _current[phase].allocations;
+        _total[phase].bytes += _current[phase].bytes;
+        _total[phase].frees += _current[phase].frees;
+    }
+
+    if(!steady || !AllocationCounter::enabled())
+        return;
+
+    ++_steadyFrames;
+    AllocationCounter::Counts total = this->getLastFrameTotal();
+    if(total.allocations == 0)
+        return;
+
+    ++_violations;
+    std::string phases;
+    for(int phase = 0 ; phase < PHASE_COUNT ; ++phase)
+    {
+        if(_lastFrame[phase].allocations > 0)
+            phases += " " + phaseName((Phase)phase) + " " + std::to_string(_lastFrame[phase].allocations) + " (" + std::to_string(_lastFrame[phase].bytes) + " bytes)";
+    }
+    logError("[FrameAllocations] Steady frame " + std::to_string(_frames) + " allocated :" + phases + ".");
+#ifdef DEBUG
+    assert(total.allocations == 0 && "Steady frames must not allocate.");
+#endif
+}
+
+AllocationCounter::Counts FrameAllocations::getLastFrameTotal()
+{
+    AllocationCounter::Counts total;
+    for(const AllocationCounter::Counts& counts : _lastFrame)
+    {
+        total.allocations += counts.allocations;
+        total.bytes += counts.bytes;
+        total.frees += counts.frees;
+    }
+    return total;
+}
+
+std::string FrameAllocations::report()
+{
+    if(!AllocationCounter::enabled())
+        return "allocations not counted, build with COUNT_ALLOCATIONS";
+    if(_frames == 0)
+        return "no frame";
+
+    std::string text = std::to_string(_frames) + " frames, " + std::to_string(_steadyFrames) + " steady, " +
+        std::to_string(_violations) + " steady frames allocated, per frame :";
+    for(int phase = 0 ; phase < PHASE_COUNT ; ++phase)
+    {
+        text += " " + phaseName((Phase)phase) + " " + std::to_string(_total[phase].allocations / (double)_frames) +
+            " (" + std::to_string(_total[phase].bytes / (double)_frames) + " bytes)";
+    }
+    return text;
+}
+
+std::string FrameAllocations::phaseName(Phase phase)
+{
+    if(phase == EVENTS)
+        return "events";
+    else if(phase == UPDATE)
+        return "update";
+    else if(phase == RENDER)
+        return "render";
+    else if(phase == PRESENT)
+        return "present";
+    return "unknown";
+}
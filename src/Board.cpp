@@ -0,0 +1,190 @@
+#include "Board.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+Board::Board(Renderer* renderer, std::string name, SDL_Texture* background, SDL_Rect destination) :
+    Node(renderer, name, background, destination)
+{
+    _retained = false;
+    this->setLayer(Renderer::LAYER_BACKGROUND);
+}
+
+Board::~Board() {}
+
+bool Board::renderTree()
+{
+    bool ok = Node::renderTree();
+
+    if(!this->renderCards())
+    {
+        logError("[Board] " + _name + " : failed to render one or more cards.");
+        ok = false;
+    }
+
+    return ok;
+}
+
+bool Board::renderCards()
+{
+    if(_atlas == nullptr || _atlas->getLevelCount() == 0)
+        return true;
+
+    SDL_Rect origin = this->getGlobalDestination();
+    SDL_Rect area = _renderer->getVisibleArea();
+    SDL_Rect visible;
+    if(!SDL_IntersectRect(&origin, &area, &visible))
+        return true;
+
+    SDL_Point topLeft = this->screenToBoard({ visible.x, visible.y });
+    SDL_Point bottomRight = this->screenToBoard({ visible.x + visible.w, visible.y + visible.h });
+    _store.query({ topLeft.x, topLeft.y, bottomRight.x - topLeft.x + 1, bottomRight.y - topLeft.y + 1 }, _visible);
+    if(_visible.empty())
+        return true;
+
+    // Every card has the same size, pick the smallest level
+    // still at least as wide as a card on screen.
+    const std::vector<SDL_Rect>& rects = _store.getRects();
+    size_t level = _atlas->pickLevel(std::ceil(rects[_visible.front()].w * _zoom));
+    const std::vector<SDL_Texture*>& fronts = _atlas->getFronts(level);
+    SDL_Texture* back = _atlas->getBack(level);
+    const std::vector<uint16_t>& textures = _store.getTextures();
+    const std::vector<uint8_t>& revealed = _store.getRevealed();
+    const std::vector<float>& scalesX = _store.getScalesX();
+    const std::vector<uint8_t>& alphas = _store.getAlphas();
+    const std::vector<uint8_t>& swapped = _store.getSwapped();
+
+    // Zoomed in cards must not spill over the menus.
+    _renderer->setLayer(Renderer::LAYER_CARDS);
+    _renderer->setClipRect(&visible);
+    bool ok = true;
+    for(uint32_t i : _visible)
+    {
+        SDL_Texture* texture = revealed[i] != swapped[i] ? fronts[textures[i]] : back;
+        SDL_Rect dest = this->boardToScreen(rects[i]);
+
+        // Animated cards stay in the batch of their texture,
+        // narrowed around their center and faded by the vertex color.
+        if(scalesX[i] != 1)
+        {
+            int width = std::lround(dest.w * scalesX[i]);
+            dest.x += (dest.w - width) / 2;
+            dest.w = width;
+        }
+        if(dest.w <= 0 || alphas[i] == 0)
+            continue;
+        if(!_renderer->renderTexture(texture, &dest, nullptr, alphas[i]))
+            ok = false;
+    }
+    _renderer->setClipRect(nullptr);
+    return ok;
+}
+
+bool Board::hitTest(SDL_Point point)
+{
+    if(!this->isVisible() || !this->hasClickEvent())
+        return false;
+
+    SDL_Rect dest = this->getGlobalDestination();
+    if(!SDL_PointInRect(&point, &dest))
+        return false;
+
+    // Clickable board catches every click, e.g. to hide a revealed pair.
+    if(_clickable)
+        return true;
+
+    int index = this->cardAt(point);
+    return index >= 0 && !_store.isRevealed(index);
+}
+
+bool Board::click(EventQueue& events, SDL_Point point, uint32_t timestamp)
+{
+    if(!this->isClickable())
+        return true;
+
+    // Resolved now, the camera may move before the event is handled.
+    Event event = this->getClickEvent();
+    event.id = this->cardAt(point);
+    event.source = this;
+    event.point = point;
+    event.timestamp = timestamp;
+    return events.push(event);
+}
+
+bool Board::isClickable()
+{
+    return this->hasClickEvent() && this->isVisible();
+}
+
+int Board::cardAt(SDL_Point point)
+{
+    return _store.cardAt(this->screenToBoard(point));
+}
+
+void Board::setAtlas(const CardAtlas* atlas)
+{
+    _atlas = atlas;
+    this->markDirty();
+}
+
+
+//===============
+// Camera
+//===============
+
+void Board::pan(int dx, int dy)
+{
+    _cameraX -= dx / _zoom;
+    _cameraY -= dy / _zoom;
+    this->clampCamera();
+    this->markDirty();
+}
+
+void Board::zoomAt(SDL_Point point, float factor)
+{
+    SDL_Rect origin = this->getGlobalDestination();
+    float x = _cameraX + (point.x - origin.x) / _zoom;
+    float y = _cameraY + (point.y - origin.y) / _zoom;
+
+    _zoom = std::clamp(_zoom * factor, 1.0f, _maxZoom);
+    _cameraX = x - (point.x - origin.x) / _zoom;
+    _cameraY = y - (point.y - origin.y) / _zoom;
+    this->clampCamera();
+    this->markDirty();
+}
+
+void Board::resetCamera(float maxZoom)
+{
+    _cameraX = 0;
+    _cameraY = 0;
+    _zoom = 1;
+    _maxZoom = std::max(maxZoom, 1.0f);
+    this->markDirty();
+}
+
+void Board::clampCamera()
+{
+    _cameraX = std::clamp(_cameraX, 0.0f, _destination.w - _destination.w / _zoom);
+    _cameraY = std::clamp(_cameraY, 0.0f, _destination.h - _destination.h / _zoom);
+}
+
+SDL_Rect Board::boardToScreen(SDL_Rect rect)
+{
+    SDL_Rect origin = this->getGlobalDestination();
+    // Both edges are rounded so that neighbours never leave a gap.
+    int x0 = std::floor((rect.x - _cameraX) * _zoom);
+    int y0 = std::floor((rect.y - _cameraY) * _zoom);
+    int x1 = std::floor((rect.x + rect.w - _cameraX) * _zoom);
+    int y1 = std::floor((rect.y + rect.h - _cameraY) * _zoom);
+    return { origin.x + x0, origin.y + y0, x1 - x0, y1 - y0 };
+}
+
+SDL_Point Board::screenToBoard(SDL_Point point)
+{
+    SDL_Rect origin = this->getGlobalDestination();
+    return {
+        (int)std::floor(_cameraX + (point.x - origin.x) / _zoom),
+        (int)std::floor(_cameraY + (point.y - origin.y) / _zoom)
+    };
+}
@@ -0,0 +1,121 @@
+#include "CardAtlas.hpp"
+#include "Card.hpp"
+#include "Logger.hpp"
+
+CardAtlas::CardAtlas(Renderer* renderer) : _renderer(renderer) {}
+
+CardAtlas::~CardAtlas()
+{
+    for(size_t level = 0 ; level < _levels.size() ; ++level)
+    {
+        for(SDL_Texture* texture : _levels[level].fronts)
+            _renderer->destroyTexture(texture);
+        if(level > 0 && _levels[level].back != _levels[level - 1].back)
+            _renderer->destroyTexture(_levels[level].back);
+    }
+    _levels.clear();
+}
+
+bool CardAtlas::addFaceSet(SDL_Texture* spriteSheet)
+{
+    logInfo("[CardAtlas] Loading cards textures from sprite sheet.");
+    if(_levels.empty())
+        _levels.push_back({ (int)Card::getCardWidth(), (int)Card::getCardHeight(), {}, nullptr });
+
+    bool ok = true;
+    uint32_t loadedCount = 0;
+    size_t first = _levels[0].fronts.size();
+    for(uint32_t id = 0 ; id < Card::cardsPerSet ; ++id)
+    {
+        SDL_Rect rect = Card::atlasRect(id);
+        // cropTexture() creates the target texture itself.
+        SDL_Texture* texture = nullptr;
+        if(!_renderer->cropTexture(spriteSheet, texture, &rect))
+        {
+            logError("[CardAtlas] Failed to crop texture for card " + Card::generateName(Card::idSuit(id), Card::idRank(id)));
+            ok = false;
+        }
+        else
+        {
+            // Vanishing cards fade out.
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+            ++loadedCount;
+        }
+        _levels[0].fronts.push_back(texture);
+    }
+
+    if(first == 0)
+    {
+        _levels[0].back = _levels[0].fronts[Card::makeId(Card::CLUBS, Card::SPECIAL)];
+        if(_levels[0].back == nullptr)
+        {
+            logError("[CardAtlas] Cannot create lower resolution levels without a back texture.");
+            return false;
+        }
+        ok &= this->createLevels();
+    }
+
+    // Each level is scaled from the previous one.
+    bool scaled = true;
+    for(size_t level = 1 ; level < _levels.size() ; ++level)
+    {
+        Level& current = _levels[level];
+        const std::vector<SDL_Texture*>& previous = _levels[level - 1].fronts;
+        for(size_t i = first ; i < previous.size() ; ++i)
+        {
+            SDL_Texture* texture = previous[i] == nullptr ? nullptr : _renderer->scaleTexture(previous[i], current.width, current.height);
+            if(previous[i] != nullptr && texture == nullptr)
+                scaled = false;
+            else if(texture != nullptr)
+                SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+            current.fronts.push_back(texture);
+        }
+    }
+    if(!scaled)
+        logWarning("[CardAtlas] Failed to create some lower resolution card textures.");
+
+    if(ok)
+        logInfo("[CardAtlas] Successfully loaded " + std::to_string(loadedCount) + "/" + std::to_string(Card::cardsPerSet) + " textures, " + std::to_string(this->getFaceSets()) + " face sets available.");
+    else
+        logWarning("[CardAtlas] Failed to load some card texture.");
+    return ok;
+}
+
+size_t CardAtlas::getFaceSets() const
+{
+    return _levels.empty() ? 0 : _levels[0].fronts.size() / Card::cardsPerSet;
+}
+
+size_t CardAtlas::pickLevel(int screenWidth) const
+{
+    size_t level = 0;
+    while(level + 1 < _levels.size() && _levels[level + 1].width >= screenWidth)
+        ++level;
+    return level;
+}
+
+bool CardAtlas::createLevels()
+{
+    bool ok = true;
+    int width = _levels[0].width;
+    int height = _levels[0].height;
+    while(width / 2 >= 8 && height / 2 >= 8)
+    {
+        width /= 2;
+        height /= 2;
+        SDL_Texture* back = _renderer->scaleTexture(_levels.back().back, width, height);
+        if(back == nullptr)
+        {
+            ok = false;
+            back = _levels.back().back;
+        }
+        else
+            SDL_SetTextureBlendMode(back, SDL_BLENDMODE_BLEND);
+        _levels.push_back({ width, height, {}, back });
+    }
+
+    if(!ok)
+        logWarning("[CardAtlas] Failed to create some lower resolution back textures.");
+    logInfo("[CardAtlas] Card textures have " + std::to_string(_levels.size()) + " levels.");
+    return true;
+}
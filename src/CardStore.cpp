@@ -0,0 +1,212 @@
+#include "CardStore.hpp"
+
+#include <algorithm>
+
+CardStore::CardStore()
+{}
+
+CardStore::~CardStore()
+{}
+
+size_t CardStore::add(uint32_t key, uint16_t texture, SDL_Rect rect)
+{
+    _rects.push_back(rect);
+    _keys.push_back(key);
+    _textures.push_back(texture);
+    _revealed.push_back(false);
+    _removed.push_back(false);
+    _scalesX.push_back(1);
+    _alphas.push_back(255);
+    _swapped.push_back(false);
+    ++_remaining;
+    this->gridInsert(_keys.size() - 1);
+    return _keys.size() - 1;
+}
+
+void CardStore::remove(size_t index)
+{
+    if(_removed[index])
+        return;
+    this->gridErase(index);
+    _removed[index] = true;
+    --_remaining;
+}
+
+void CardStore::clear()
+{
+    _rects.clear();
+    _keys.clear();
+    _textures.clear();
+    _revealed.clear();
+    _removed.clear();
+    _scalesX.clear();
+    _alphas.clear();
+    _swapped.clear();
+    _remaining = 0;
+    for(std::vector<uint32_t>& cell : _cells)
+        cell.clear();
+}
+
+void CardStore::reserve(size_t count)
+{
+    _rects.reserve(count);
+    _keys.reserve(count);
+    _textures.reserve(count);
+    _revealed.reserve(count);
+    _removed.reserve(count);
+    _scalesX.reserve(count);
+    _alphas.reserve(count);
+    _swapped.reserve(count);
+}
+
+void CardStore::setGrid(int width, int height, int cellWidth, int cellHeight)
+{
+    _cellWidth = std::max(cellWidth, 1);
+    _cellHeight = std::max(cellHeight, 1);
+    _gridColumns = std::max((width + _cellWidth - 1) / _cellWidth, 1);
+    _gridRows = std::max((height + _cellHeight - 1) / _cellHeight, 1);
+    _cells.assign(_gridColumns * _gridRows, std::vector<uint32_t>());
+
+    for(size_t i = 0 ; i < _keys.size() ; ++i)
+    {
+        if(!_removed[i])
+            this->gridInsert(i);
+    }
+}
+
+void CardStore::setRect(size_t index, SDL_Rect rect)
+{
+    bool indexed = !_removed[index];
+    if(indexed)
+        this->gridErase(index);
+    _rects[index] = rect;
+    if(indexed)
+        this->gridInsert(index);
+}
+
+int CardStore::cardAt(SDL_Point point)
+{
+    int x0, y0, x1, y1;
+    if(!this->cellRange({ point.x, point.y, 1, 1 }, x0, y0, x1, y1))
+    {
+        for(size_t i = 0 ; i < _rects.size() ; ++i)
+        {
+            if(!_removed[i] && SDL_PointInRect(&point, &_rects[i]))
+                return i;
+        }
+        return -1;
+    }
+
+    // Lowest index wins, as without the grid.
+    int found = -1;
+    for(uint32_t i : _cells[y0 * _gridColumns + x0])
+    {
+        if(SDL_PointInRect(&point, &_rects[i]) && (found < 0 || (int)i < found))
+            found = i;
+    }
+    return found;
+}
+
+bool CardStore::overlaps(SDL_Rect rect)
+{
+    int x0, y0, x1, y1;
+    if(!this->cellRange(rect, x0, y0, x1, y1))
+    {
+        for(size_t i = 0 ; i < _rects.size() ; ++i)
+        {
+            if(!_removed[i] && SDL_HasIntersection(&rect, &_rects[i]))
+                return true;
+        }
+        return false;
+    }
+
+    for(int y = y0 ; y <= y1 ; ++y)
+    {
+        for(int x = x0 ; x <= x1 ; ++x)
+        {
+            for(uint32_t i : _cells[y * _gridColumns + x])
+            {
+                if(SDL_HasIntersection(&rect, &_rects[i]))
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+void CardStore::query(SDL_Rect rect, std::vector<uint32_t>& indices)
+{
+    indices.clear();
+    int x0, y0, x1, y1;
+    if(!this->cellRange(rect, x0, y0, x1, y1))
+    {
+        for(size_t i = 0 ; i < _rects.size() ; ++i)
+        {
+            if(!_removed[i] && SDL_HasIntersection(&rect, &_rects[i]))
+                indices.push_back(i);
+        }
+        return;
+    }
+
+    for(int y = y0 ; y <= y1 ; ++y)
+    {
+        for(int x = x0 ; x <= x1 ; ++x)
+        {
+            for(uint32_t i : _cells[y * _gridColumns + x])
+            {
+                // A card spanning several cells is only listed from
+                // the first of its cells inside the queried range.
+                int cx0, cy0, cx1, cy1;
+                this->cellRange(_rects[i], cx0, cy0, cx1, cy1);
+                if(x == std::max(cx0, x0) && y == std::max(cy0, y0) && SDL_HasIntersection(&rect, &_rects[i]))
+                    indices.push_back(i);
+            }
+        }
+    }
+}
+
+bool CardStore::cellRange(SDL_Rect rect, int& x0, int& y0, int& x1, int& y1)
+{
+    if(_cells.empty())
+        return false;
+
+    x0 = std::clamp(rect.x / _cellWidth, 0, _gridColumns - 1);
+    y0 = std::clamp(rect.y / _cellHeight, 0, _gridRows - 1);
+    x1 = std::clamp((rect.x + std::max(rect.w, 1) - 1) / _cellWidth, 0, _gridColumns - 1);
+    y1 = std::clamp((rect.y + std::max(rect.h, 1) - 1) / _cellHeight, 0, _gridRows - 1);
+    return true;
+}
+
+void CardStore::gridInsert(size_t index)
+{
+    int x0, y0, x1, y1;
+    if(!this->cellRange(_rects[index], x0, y0, x1, y1))
+        return;
+
+    for(int y = y0 ; y <= y1 ; ++y)
+    {
+        for(int x = x0 ; x <= x1 ; ++x)
+            _cells[y * _gridColumns + x].push_back(index);
+    }
+}
+
+void CardStore::gridErase(size_t index)
+{
+    int x0, y0, x1, y1;
+    if(!this->cellRange(_rects[index], x0, y0, x1, y1))
+        return;
+
+    for(int y = y0 ; y <= y1 ; ++y)
+    {
+        for(int x = x0 ; x <= x1 ; ++x)
+        {
+            std::vector<uint32_t>& cell = _cells[y * _gridColumns + x];
+            auto found = std::find(cell.begin(), cell.end(), index);
+            if(found != cell.end())
+            {
+                *found = cell.back();
+                cell.pop_back();
+            }
+        }
+    }
+}
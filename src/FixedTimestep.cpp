@@ -0,0 +1,35 @@
+#include "FixedTimestep.hpp"
+
+FixedTimestep::FixedTimestep(uint64_t step, uint64_t maxFrame) :
+    _step(step == 0 ? 1 : step),
+    _maxFrame(maxFrame < _step ? _step : maxFrame)
+{}
+
+void FixedTimestep::advance(uint64_t now)
+{
+    if(!_started)
+    {
+        _started = true;
+        _previousFrame = now;
+        _accumulator = _step;
+        return;
+    }
+
+    uint64_t frame = now - _previousFrame;
+    _previousFrame = now;
+    if(frame > _maxFrame)
+    {
+        _dropped += frame - _maxFrame;
+        frame = _maxFrame;
+    }
+    _accumulator += frame;
+}
+
+bool FixedTimestep::step()
+{
+    if(_accumulator < _step)
+        return false;
+    _accumulator -= _step;
+    _time += _step;
+    return true;
+}
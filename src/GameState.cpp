@@ -0,0 +1,101 @@
+#include "GameState.hpp"
+
+#include <algorithm>
+
+bool GameState::reset(uint32_t players, uint32_t pairs)
+{
+    if(players == 0 || players > maxPlayers || pairs > maxPairs)
+        return false;
+
+    uint32_t cards = std::max<uint32_t>(_cards, pairs * 2);
+    std::fill(_keys, _keys + cards, 0);
+    std::fill(_revealed, _revealed + cards, 0);
+    std::fill(_removed, _removed + cards, 0);
+    std::fill(_scores, _scores + maxPlayers, 0);
+
+    _activePlayer = 0;
+    _pairsFound = 0;
+    _cards = 0;
+    _first = -1;
+    _second = -1;
+    _turns = 0;
+    _players = players;
+    _pairs = pairs;
+    _phase = NO_CARD_REVEALED;
+    return true;
+}
+
+bool GameState::addCard(uint32_t key)
+{
+    if(_cards >= _pairs * 2)
+        return false;
+
+    _keys[_cards] = key;
+    ++_cards;
+    return true;
+}
+
+bool GameState::canPick(uint32_t card) const
+{
+    return (_phase == NO_CARD_REVEALED || _phase == ONE_CARD_REVEALED) &&
+        card < _cards && !_removed[card] && !_revealed[card];
+}
+
+bool GameState::step(GameAction action)
+{
+    if(action.type == GameAction::CLICK)
+        action.type = _phase == NO_PAIR || _phase == PAIR_FOUND ? GameAction::ACKNOWLEDGE : GameAction::PICK;
+
+    if(action.type == GameAction::PICK)
+    {
+        if(!this->canPick(action.card))
+            return false;
+        this->pick(action.card);
+        return true;
+    }
+
+    if(_phase != NO_PAIR && _phase != PAIR_FOUND)
+        return false;
+    this->acknowledge();
+    return true;
+}
+
+void GameState::pick(uint32_t card)
+{
+    _revealed[card] = true;
+
+    if(_phase == NO_CARD_REVEALED)
+    {
+        _first = card;
+        _phase = ONE_CARD_REVEALED;
+        return;
+    }
+
+    _second = card;
+    ++_turns;
+    if(_keys[_first] == _keys[_second])
+    {
+        ++_scores[_activePlayer];
+        ++_pairsFound;
+        _phase = PAIR_FOUND;
+    }
+    else
+    {
+        _activePlayer = this->getNextPlayer();
+        _phase = NO_PAIR;
+    }
+}
+
+void GameState::acknowledge()
+{
+    if(_phase == PAIR_FOUND)
+    {
+        _removed[_first] = true;
+        _removed[_second] = true;
+    }
+    _revealed[_first] = false;
+    _revealed[_second] = false;
+    _first = -1;
+    _second = -1;
+    _phase = NO_CARD_REVEALED;
+}
@@ -0,0 +1,255 @@
+#include "GameThread.hpp"
+#include "Logger.hpp"
+#include "Watchdog.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+GameThread::GameThread(std::vector<uint32_t> highScores, std::string savePath) :
+    _highScores(highScores),
+    _savePath(savePath)
+{
+    _thread = std::thread(&GameThread::run, this);
+}
+
+GameThread::~GameThread()
+{
+    this->push(GameCommand::quit());
+    _thread.join();
+}
+
+
+//====================
+// Main thread
+//====================
+
+void GameThread::push(const GameCommand& command)
+{
+    while(!_commands.push(command))
+        std::this_thread::yield();
+    ++_pushed;
+
+    // Pairs with the fence in run(): either the game thread sees
+    // the command before sleeping, or we see it sleeping.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(_sleeping)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _wakeUp.notify_one();
+    }
+}
+
+bool GameThread::consume()
+{
+    return _snapshots.consume();
+}
+
+void GameThread::waitIdle()
+{
+    Watchdog::Zone zone("GameThread::waitIdle");
+    this->consume();
+    while(this->getSnapshot().processed != _pushed)
+    {
+        std::this_thread::yield();
+        this->consume();
+    }
+}
+
+
+//====================
+// Game thread
+//====================
+
+void GameThread::run()
+{
+    GameCommand command;
+    while(true)
+    {
+        // Publish once per batch, the main thread only wants the latest.
+        bool applied = false;
+        while(_commands.pop(command))
+        {
+            if(this->apply(command))
+            {
+                this->publish();
+                return;
+            }
+            applied = true;
+        }
+        if(applied)
+        {
+            this->publish();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _sleeping = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        _wakeUp.wait(lock, [this] { return !_commands.empty(); });
+        _sleeping = false;
+    }
+}
+
+bool GameThread::apply(const GameCommand& command)
+{
+    ++_state.processed;
+    GameState& game = _state.game;
+
+    if(command.type == GameCommand::TICK)
+        this->tick(command.time, command.paused);
+    else if(command.type == GameCommand::RESET)
+    {
+        if(!game.reset(command.players, command.pairs))
+            logError("[GameThread] Cannot start a game of " + std::to_string(command.pairs) + " pairs for " + std::to_string(command.players) + " players.");
+        _previousTick = command.time;
+        _state.duration = 0;
+        _state.record = command.pairs < _highScores.size() ? _highScores[command.pairs] : 0;
+        ++_state.resets;
+        ++_state.steps;
+    }
+    else if(command.type == GameCommand::ADD_CARD)
+    {
+        game.addCard(command.value);
+        ++_state.steps;
+    }
+    else if(command.type == GameCommand::PLAY)
+        this->play(command.action);
+    else if(command.type == GameCommand::MENU)
+    {
+        game = GameState();
+        _state.duration = 0;
+        ++_state.resets;
+        ++_state.steps;
+    }
+    else if(command.type == GameCommand::QUIT)
+        return true;
+
+    return false;
+}
+
+void GameThread::tick(uint64_t time, bool paused)
+{
+    const GameState& game = _state.game;
+    uint64_t elapsed = time - _previousTick;
+    _previousTick = time;
+    if(game.getPhase() == GameState::MENU)
+        return;
+
+    // Every update counts, the timer display is throttled by the main thread.
+    if(!paused && !game.isOver())
+        _state.duration += elapsed;
+}
+
+void GameThread::play(GameAction action)
+{
+    GameState& game = _state.game;
+    if(!game.step(action))
+        return;
+    ++_state.steps;
+
+    // High scores are saved in milliseconds.
+    uint32_t pairs = game.getPairs();
+    uint32_t duration = _state.duration / 1000;
+    if(game.getPhase() == GameState::PAIR_FOUND && game.isOver() && game.getPlayers() == 1 &&
+        pairs < _highScores.size() && (duration < _highScores[pairs] || _highScores[pairs] == 0))
+    {
+        _highScores[pairs] = duration;
+        _state.record = duration;
+        this->save();
+    }
+}
+
+void GameThread::publish()
+{
+    _snapshots.back() = _state;
+    _snapshots.publish();
+}
+
+
+//==========================
+// High scores saving
+//==========================
+
+bool GameThread::readSave(std::string path, std::vector<uint32_t>& highScores)
+{
+    std::fill(highScores.begin(), highScores.end(), 0);
+
+    if(!std::filesystem::exists(path))
+    {
+        logInfo("[GameThread] A new high scores file will be created.");
+        return true;
+    }
+
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if(!file.is_open())
+    {
+        logError("[GameThread] Failed to open save file for reading.");
+        return false;
+    }
+
+    char magic[sizeof(_saveMagic)] = {};
+    file.read(magic, sizeof(magic));
+    if(!file || std::memcmp(magic, _saveMagic, sizeof(magic)) != 0)
+    {
+        // First format : one time per pair count up to a single deck.
+        file.clear();
+        file.seekg(0);
+        uint32_t tmp = 0;
+        for(uint32_t i = 0 ; i <= GameState::deckPairs && i < highScores.size() && file.read((char*)&tmp, sizeof(tmp)) ; ++i)
+            highScores[i] = tmp;
+        logInfo("[GameThread] High scores loaded from the first save format.");
+        return true;
+    }
+
+    // Current format : count, then only the pair counts with a time.
+    uint32_t count = 0;
+    file.read((char*)&count, sizeof(count));
+    for(uint32_t i = 0 ; i < count && file ; ++i)
+    {
+        uint32_t pairs = 0;
+        uint32_t time = 0;
+        file.read((char*)&pairs, sizeof(pairs));
+        file.read((char*)&time, sizeof(time));
+        if(file && pairs < highScores.size())
+            highScores[pairs] = time;
+    }
+
+    if(!file)
+    {
+        logError("[GameThread] Save file is truncated.");
+        return false;
+    }
+    logInfo("[GameThread] High scores loaded.");
+    return true;
+}
+
+bool GameThread::save()
+{
+    if(!_saveEnabled)
+    {
+        logInfo("[GameThread] Saving disabled, high scores not written.");
+        return true;
+    }
+
+    std::ofstream file(_savePath, std::ios::out | std::ios::binary);
+    if(!file.is_open())
+    {
+        logError("[GameThread] Failed to open save file for writing.");
+        return false;
+    }
+
+    uint32_t count = std::count_if(_highScores.begin(), _highScores.end(), [](uint32_t time) { return time != 0; });
+    file.write(_saveMagic, sizeof(_saveMagic));
+    file.write((char*)&count, sizeof(count));
+    for(uint32_t pairs = 0 ; pairs < _highScores.size() ; ++pairs)
+    {
+        if(_highScores[pairs] == 0)
+            continue;
+        file.write((char*)&pairs, sizeof(pairs));
+        file.write((char*)&_highScores[pairs], sizeof(_highScores[pairs]));
+    }
+    logInfo("[GameThread] High scores saved.");
+    return true;
+}
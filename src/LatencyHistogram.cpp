@@ -0,0 +1,69 @@
+#include "LatencyHistogram.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+void LatencyHistogram::record(uint32_t ms)
+{
+    ++_buckets[std::min(ms, maxMs)];
+    ++_count;
+    _sum += ms;
+    _max = std::max(_max, ms);
+}
+
+void LatencyHistogram::clear()
+{
+    std::fill(std::begin(_buckets), std::end(_buckets), 0);
+    _count = 0;
+    _sum = 0;
+    _max = 0;
+}
+
+uint32_t LatencyHistogram::percentile(double part) const
+{
+    if(_count == 0)
+        return 0;
+
+    uint64_t rank = std::max<uint64_t>(std::ceil(part * _count), 1);
+    uint64_t seen = 0;
+    for(uint32_t ms = 0 ; ms < maxMs ; ++ms)
+    {
+        seen += _buckets[ms];
+        if(seen >= rank)
+            return ms;
+    }
+    return _max;
+}
+
+std::string LatencyHistogram::summary() const
+{
+    if(_count == 0)
+        return "no sample";
+
+    return "p50 " + std::to_string(this->percentile(0.5)) +
+        " ms, p95 " + std::to_string(this->percentile(0.95)) +
+        " ms, p99 " + std::to_string(this->percentile(0.99)) +
+        " ms, max " + std::to_string(_max) +
+        " ms over " + std::to_string(_count);
+}
+
+bool LatencyHistogram::dump(std::string path) const
+{
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if(!file.is_open())
+    {
+        logError("[LatencyHistogram] Failed to open " + path + " for writing.");
+        return false;
+    }
+
+    file << "# " << this->summary() << ", mean " << this->getMean() << " ms" << std::endl;
+    file << "ms,count" << std::endl;
+    for(uint32_t ms = 0 ; ms <= maxMs ; ++ms)
+    {
+        if(_buckets[ms] > 0)
+            file << ms << (ms == maxMs ? "+" : "") << "," << _buckets[ms] << std::endl;
+    }
+    return true;
+}
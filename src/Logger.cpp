@@ -3,6 +3,8 @@
 #include <iostream>
 #include <fstream>
 #include <ctime>
+#include <mutex>
+#include <deque>
 
 std::string getTime (const char* format = "%d-%m-%Y %H:%M:%S")
 {
@@ -17,18 +19,32 @@ std::string getTime (const char* format = "%d-%m-%Y %H:%M:%S")
   return std::string(buffer);
 }
 
+// The game thread logs too.
+static std::mutex logMutex;
+
+// Last records, for stall dumps.
+static std::deque<std::string> recentRecords;
+static const size_t recentRecordsMax = 64;
+
 void log(std::string level, std::string msg)
 {
+    std::lock_guard<std::mutex> lock(logMutex);
+
+    std::string record = getTime() + " [" + level + "] " + msg;
+    recentRecords.push_back(record);
+    if(recentRecords.size() > recentRecordsMax)
+        recentRecords.pop_front();
+
     bool tofile = true;
     if(tofile)
     {
         std::ofstream file;
         file.open ("log.txt", std::fstream::out | std::fstream::app);
-        file << getTime() << " [" << level << "] " << msg << std::endl;
+        file << record << std::endl;
         file.close();
     }
     else
-        std::cout << getTime() << " [" << level << "] " << msg << std::endl;
+        std::cout << record << std::endl;
 }
 
 void logInfo(std::string msg)
@@ -50,6 +66,15 @@ void logError(std::string msg)
     log("ERROR", msg);
 }
 
+bool logRecent(std::vector<std::string>& records)
+{
+    std::unique_lock<std::mutex> lock(logMutex, std::try_to_lock);
+    if(!lock.owns_lock())
+        return false;
+    records.assign(recentRecords.begin(), recentRecords.end());
+    return true;
+}
+
 void logInit()
 {
     std::remove("log.txt");
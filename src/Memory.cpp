@@ -1,38 +1,42 @@
 #include "Memory.hpp"
 #include "Logger.hpp"
+#include "Watchdog.hpp"
 
 #include <algorithm>
-#include <fstream>
-#include <filesystem>
+#include <cmath>
 
 #include <iomanip> // For timer formatting.
 #include <sstream>
 
-Memory::Memory(Renderer* renderer, SDL_Texture* spriteSheet, SDL_Texture* background) : Node(renderer, "root")
+Memory::Memory(Renderer* renderer, const CardAtlas* atlas, SDL_Texture* background, SDL_Rect area, std::string savePath) :
+    Node(renderer, "root", nullptr, area),
+    _savePath(savePath),
+    _atlas(atlas)
 {
     _background = background;
+    if(this->hasEmptyDestination())
+        this->setDestination({ 0, 0, renderer->getWidth(), renderer->getHeight() });
 
-    if(!this->readSave())
+    _highScores.assign(_maxPairs + 1, 0);
+    if(!GameThread::readSave(_savePath, _highScores))
         logError("[Memory] Failed to read saved high scores.");
-
-    this->loadTextures(spriteSheet);
-    Card::setBackTexture(_textureSet[Card::CLUBS][Card::SPECIAL]);
+    _gameThread.reset(new GameThread(_highScores, _savePath));
 
     _buttonMouseHandler.setHighlight(true);
 
     SDL_Rect dst;
-    dst.h = renderer->getHeight();
-    dst.w = renderer->getWidth() * _boardWidthRel;
+    dst.h = this->getHeight();
+    dst.w = this->getWidth() * _boardWidthRel;
     dst.x = 0;
     dst.y = 0;
-    _board = new Node(renderer, "board", background, dst);
+    _board = new Board(renderer, "board", background, dst);
     this->addChild(_board);
-    _cardMouseHandler.setActionArea(dst);
+    _cardMouseHandler.setActionArea(_board->getGlobalDestination());
+    _board->setAtlas(_atlas);
 
-    // FIXME board should have its own callback.
-    // Its currently casted to Card* type, which is wrong
-    // but it works because no function is called on it.
-    _board->setCallback(std::bind(&Memory::cardCallback, this, std::placeholders::_1));
+    // Cards are hit tested by the board itself,
+    // clicks on them come as CARD_CLICKED events.
+    _board->setClickEvent(Event::cardClicked());
     _board->setClickable(false);
     _cardMouseHandler.addSubscriber(_board);
 
@@ -44,6 +48,9 @@ Memory::Memory(Renderer* renderer, SDL_Texture* spriteSheet, SDL_Texture* backgr
         pairs->centerX();
         pairs->setY(_mainMenu->getHeight() * 0.5);
         this->addChild(_mainMenu);
+
+        // Menus change a few times a second at most.
+        _mainMenu->setCached(true);
     }
     _buttonMouseHandler.setActionArea(_mainMenu->getGlobalDestination());
 }
@@ -58,18 +65,18 @@ Node* Memory::createMainMenu()
 {
     std::vector<std::string> texts = { "1 joueur", "2 joueurs", "+", "++", "-", "--", "Demarrer", "Quitter" };
     std::vector<double> yFactors = { 0.1, 0.2, 0.6, 0.6, 0.6, 0.6, 0.8, 0.9 };
-    std::vector<bool (Memory::*)(Node*)> callbacks = {
-        &Memory::onePlayer,
-        &Memory::twoPlayers,
-        &Memory::incPairs,
-        &Memory::incPairs10,
-        &Memory::decPairs,
-        &Memory::decPairs10,
-        &Memory::start,
-        &Memory::buttonQuit,
+    std::vector<Button> buttons = {
+        BUTTON_ONE_PLAYER,
+        BUTTON_TWO_PLAYERS,
+        BUTTON_INC_PAIRS,
+        BUTTON_INC_PAIRS_10,
+        BUTTON_DEC_PAIRS,
+        BUTTON_DEC_PAIRS_10,
+        BUTTON_START,
+        BUTTON_QUIT,
     };
 
-    Node* menu = this->createMenu("main_menu", _mainMenuButtonsNames, texts, yFactors, callbacks);
+    Node* menu = this->createMenu("main_menu", _mainMenuButtonsNames, texts, yFactors, buttons);
     if(menu != nullptr)
     {
         Node* buttonInc = menu->findChild("button_inc_pairs");
@@ -99,12 +106,12 @@ Node* Memory::createGameMenu()
 {
     std::vector<std::string> texts = { "Menu", "Quitter" };
     std::vector<double> yFactors = { 0.8, 0.9 };
-    std::vector<bool (Memory::*)(Node*)> callbacks = {
-        &Memory::newGame,
-        &Memory::buttonQuit
+    std::vector<Button> buttons = {
+        BUTTON_NEW_GAME,
+        BUTTON_QUIT
     };
 
-    Node* menu =  this->createMenu("game_menu", _gameMenuButtonsNames, texts, yFactors, callbacks);
+    Node* menu =  this->createMenu("game_menu", _gameMenuButtonsNames, texts, yFactors, buttons);
 
     for(uint32_t i = 0 ; i < _playersNb ; ++i)
     {
@@ -129,6 +136,7 @@ Node* Memory::createGameMenu()
         record->setY(menu->getHeight() * 0.7);
     }
 
+    menu->setCached(true);
     _gameMenu = menu;
     return menu;
 }
@@ -138,10 +146,10 @@ Node* Memory::createMenu(
     std::vector<std::string> buttonNames,
     std::vector<std::string> buttonTexts,
     std::vector<double> buttonYFactors,
-    std::vector<bool (Memory::*)(Node*)> callbacks
+    std::vector<Button> buttons
 )
 {
-    if(!(buttonNames.size() == buttonTexts.size() && buttonTexts.size() == buttonYFactors.size()))
+    if(!(buttonNames.size() == buttonTexts.size() && buttonTexts.size() == buttonYFactors.size() && buttonYFactors.size() == buttons.size()))
     {
         logError("[Memory] Cannot create menu, provided vectors don't all have the same size.");
         return nullptr;
@@ -154,9 +162,9 @@ Node* Memory::createMenu(
     }
 
     SDL_Rect dst;
-    dst.h = _renderer->getHeight();
-    dst.w = _renderer->getWidth() * (1 - _boardWidthRel);
-    dst.x = _renderer->getWidth() * _boardWidthRel;
+    dst.h = this->getHeight();
+    dst.w = this->getWidth() * (1 - _boardWidthRel);
+    dst.x = this->getWidth() * _boardWidthRel;
     dst.y = 0;
     Node* menu = new Node(_renderer, menuName, nullptr, dst);
 
@@ -171,84 +179,38 @@ Node* Memory::createMenu(
 
         button->centerX();
         button->setY(menu->getHeight() * buttonYFactors[i]);
-        button->setCallback(std::bind(callbacks[i], this, std::placeholders::_1));
+        button->setClickEvent(Event::buttonPressed(buttons[i]));
         _buttonMouseHandler.addSubscriber(button);
     }
 
     return menu;
 }
 
-bool Memory::loadTextures(SDL_Texture* spriteSheet)
+std::vector<uint32_t> Memory::dealKeys()
 {
-    logInfo("[Memory] Loading cards textures from sprite sheet.");
-    bool ok = true;
-    uint32_t loadedCount = 0;
-    uint32_t total = 0;
-    for (size_t i = 0; i <= Card::DIAMONDS; i++)
-    {
-        for (size_t j = 0; j <= Card::SPECIAL; j++)
-        {
-            SDL_Rect rect;
-            rect.h = Card::getCardHeight();
-            rect.w = Card::getCardWidth();
-            rect.x = Card::getCardWidth() * j;
-            rect.y = Card::getCardHeight() * i;
-            SDL_Texture* texture = _renderer->createBlankRenderTarget(Card::getCardWidth(), Card::getCardHeight());
-            bool subok = true;
-            if(texture == nullptr)
-            {
-                logError("[Memory] Failed to create blank texture for card " + Card::getRankName(j) + " of " + Card::getSuitName(i));
-                ok = false;
-                subok = false;
-            }
-
-            if(!_renderer->cropTexture(spriteSheet, texture, &rect))
-            {
-                logError("[Memory] Failed to crop texture for card " + Card::getRankName(j) + " of " + Card::getSuitName(i));
-                ok = false;
-                subok = false;
-            }
-
-            if(subok)
-                ++loadedCount;
-            
-            ++total;
-            _textureSet[i][j] = texture;
-        }
-    }
-    if(ok)
-        logInfo("[Memory] Successfully loaded " + std::to_string(loadedCount) + "/" + std::to_string(total) + " textures.");
-    else
-        logWarning("[Memory] Failed to load some card texture.");
-    return ok;
-}
-
-Card* Memory::randomCard()
-{
-    int i, j;
-    bool duplicate = true;
-    while(duplicate)
+    // Fisher-Yates on rand() so that a seed gives the same deal everywhere.
+    uint32_t faces = _atlas->getFaceSets() * Card::facesPerSet;
+    std::vector<uint32_t> order(faces);
+    std::vector<uint32_t> keys;
+    keys.reserve(_pairs);
+    for(int i = 0 ; i < _pairs ; ++i)
     {
-        duplicate = false;
-        i = rand() % (Card::DIAMONDS + 1);
-        j = rand() % Card::SPECIAL;
-        uint32_t key = j * 10 + i;
-
-        //Loop through already rendered cards to check if the new one is a duplicate.
-        for(auto card : _pickedCard)
+        uint32_t face = i % faces;
+        if(face == 0)
         {
-            //Check if duplicate.
-            if(key == card->getKey())
-                duplicate = true;
+            for(uint32_t j = 0 ; j < faces ; ++j)
+                order[j] = j;
+            for(uint32_t j = faces - 1 ; j > 0 ; --j)
+                std::swap(order[j], order[rand() % (j + 1)]);
         }
+        keys.push_back(Card::faceKey(order[face]));
     }
-
-    //If not duplicate return the card.
-    return new Card(_renderer, i, j, _textureSet[i][j]);
+    return keys;
 }
 
 SDL_Rect Memory::randomDestination(int w, int h, int maxX, int maxY)
 {
+    Watchdog::Zone zone("Memory::randomDestination");
     SDL_Rect destination;
     destination.w = w ; destination.h = h;
 
@@ -260,104 +222,183 @@ SDL_Rect Memory::randomDestination(int w, int h, int maxX, int maxY)
         destination.x = rand() % maxX;
         destination.y = rand() % maxY;
 
-        //Loop through already rendered rectangles to check if the new one is overlapping with one.
-        for(auto card : _pickedCard)
-        {
-            SDL_Rect currentRect = card->getDestination();
-            //Check overlapping.
-            if(SDL_HasIntersection(&destination, &currentRect))
-            {
-                overlap = true;
-            }
-        }
+        //Check if the new rectangle is overlapping with an already placed card.
+        overlap = _board->getStore()->overlaps(destination);
     }
 
     //If no overlapping assign the rectangle to the card.
     return destination;
 }
 
+std::vector<SDL_Rect> Memory::gridDestinations(uint32_t cards, int& w, int& h)
+{
+    // Cells leave a quarter of a card around each one for jitter.
+    int boardW = _board->getWidth();
+    int boardH = _board->getHeight();
+    double scale = std::sqrt((double)boardW * boardH / (cards * w * h * 1.25 * 1.25));
+    int cellW, cellH, columns, rows;
+    do
+    {
+        cellW = std::max<int>(w * scale * 1.25, 2);
+        cellH = std::max<int>(h * scale * 1.25, 2);
+        columns = boardW / cellW;
+        rows = boardH / cellH;
+        scale *= 0.98;
+    }
+    while((uint64_t)columns * rows < cards && cellW > 2 && cellH > 2);
+
+    w = std::max<int>(cellW / 1.25, 1);
+    h = std::max<int>(cellH / 1.25, 1);
+
+    uint32_t cells = columns * rows;
+    std::vector<uint32_t> order(cells);
+    for(uint32_t i = 0 ; i < cells ; ++i)
+        order[i] = i;
+    for(uint32_t i = cells - 1 ; i > 0 ; --i)
+        std::swap(order[i], order[rand() % (i + 1)]);
+
+    std::vector<SDL_Rect> destinations;
+    destinations.reserve(cards);
+    for(uint32_t i = 0 ; i < cards && i < cells ; ++i)
+    {
+        SDL_Rect destination;
+        destination.w = w;
+        destination.h = h;
+        destination.x = order[i] % columns * cellW + rand() % (cellW - w + 1);
+        destination.y = order[i] / columns * cellH + rand() % (cellH - h + 1);
+        destinations.push_back(destination);
+    }
+    return destinations;
+}
+
 void Memory::createPairs()
 {
+    Watchdog::Zone zone("Memory::createPairs");
     logInfo("[Memory] Creating " + std::to_string(_pairs) + " pairs.");
-    int done = 0;
-    for(int i = 0 ; i < _pairs ; ++i)
-    {
-        logInfo("[Memory] Generating a random card...");
-        Card* card = this->randomCard();
-        if(card == nullptr)
-        {
-            logError("[Memory] Failed to get a random card.");
-            return;
-        }
-        logInfo("[Memory] Generated random card " + card->getName());
+    CardStore* store = _board->getStore();
+    uint32_t cards = _pairs * 2;
+    store->reserve(cards);
+    _board->getTweens()->reserve(cards);
+
+    int w = Card::getCardWidth();
+    int h = Card::getCardHeight();
+    double coverage = (double)cards * w * h / ((double)_board->getWidth() * _board->getHeight());
 
-        Card* card2 = new Card(_renderer, card->getSuit(), card->getRank(), card->getTexture());
+    // Large boards cannot be scattered at random without stalling,
+    // their cards are shrunk and dealt on a shuffled grid.
+    std::vector<SDL_Rect> destinations;
+    if(coverage > _maxScatteredCoverage)
+        destinations = this->gridDestinations(cards, w, h);
+    store->setGrid(_board->getWidth(), _board->getHeight(), w, h);
 
-        this->prepareCard(card, "_1");
-        this->prepareCard(card2, "_2");
-        ++done;
-        logInfo("[Memory] Created " + std::to_string(done) + "/" + std::to_string(_pairs) + " pairs.");
+    // Only whole pairs are dealt, or the game could never end.
+    uint32_t pairs = _pairs;
+    if(!destinations.empty() && destinations.size() < cards)
+    {
+        pairs = destinations.size() / 2;
+        logWarning("[Memory] No room on the board for " + std::to_string(_pairs) + " pairs, dealing " + std::to_string(pairs) + ".");
+    }
+    _gameThread->push(GameCommand::reset(_playersNb, pairs, _time));
+
+    std::vector<uint32_t> keys = this->dealKeys();
+    for(uint32_t i = 0 ; i < pairs * 2 ; ++i)
+    {
+        SDL_Rect destination;
+        if(destinations.empty())
+            destination = this->randomDestination(w, h, _board->getWidth() - w, _board->getHeight() - h);
+        else
+            destination = destinations[i];
+        this->prepareCard(keys[i / 2], destination);
     }
+
+    logInfo("[Memory] Created " + std::to_string(store->size() / 2) + "/" + std::to_string(_pairs) + " pairs of " + std::to_string(w) + "x" + std::to_string(h) + " cards.");
 }
 
-void Memory::prepareCard(Card* card, std::string suffixe)
+void Memory::prepareCard(uint32_t key, SDL_Rect destination)
 {
-    card->setName(card->getName() + suffixe);
-    logInfo("[Memory] Looking for a random destination for " + card->getName());
-        card->setDestination(this->randomDestination(
-        card->getWidth(),
-        card->getHeight(),
-        _board->getWidth() - card->getWidth(),
-        _board->getHeight() - card->getHeight()
-    ));
-    logInfo("[Memory] Found random destination for " + card->getName());
-    card->setCallback(std::bind(&Memory::cardCallback, this, std::placeholders::_1));
-    _cardMouseHandler.addSubscriber(card);
-    card->flip();
-    _pickedCard.push_back(card);
-    _board->addChild(card);
+    _board->getStore()->add(key, Card::keyTextureIndex(key), destination);
+    _gameThread->push(GameCommand::addCard(key));
 }
 
-void Memory::removeCard(Card* card)
+void Memory::removeCard(size_t index)
 {
-    _board->removeChild(card);
-    _cardMouseHandler.removeSubscriber(card);
-    auto search = std::find(_pickedCard.begin(), _pickedCard.end(), card);
-    _pickedCard.erase(search);
-    delete card;
+    _board->getTweens()->start(index, TweenSet::VANISH, _vanishDuration);
 }
 
 void Memory::update()
 {
+    Watchdog::Zone zone("Memory::update");
     if(!_pause)
         this->motion();
+    this->handleEvents();
+
+    // Before syncing, tweens started by this update are shown from their start.
+    TweenSet* tweens = _board->getTweens();
+    tweens->update(_time - _previousTime, *_board->getStore());
+
+    // The game clock runs on the game thread too.
+    uint64_t steps = _syncedSteps;
+    _gameThread->push(GameCommand::tick(_time, _pause));
+    if(_lockstep)
+        _gameThread->waitIdle();
+    else
+        _gameThread->consume();
+    this->syncGame();
+
+    // A click anywhere on the board hides or removes the revealed cards, once they are shown.
+    GameState::Phase phase = this->getGame().getPhase();
+    _board->setClickable((phase == GameState::NO_PAIR || phase == GameState::PAIR_FOUND) && tweens->getRunning(TweenSet::FLIP) == 0);
 
-    if(_state > 0)
+    if(_syncedSteps != steps)
+        _active = true;
+
+    this->updateStats();
+}
+
+void Memory::interpolate(float alpha)
+{
+    // Counted per rendered frame, updates may run several times or not at all.
+    if(_active)
+        _quietFrames = 0;
+    else
+        ++_quietFrames;
+    _active = false;
+
+    _board->getTweens()->apply(alpha * (_time - _previousTime), *_board->getStore());
+
+    // The clock runs between updates too, unless the game thread stopped it.
+    uint64_t duration = _gameDuration;
+    const GameState& game = this->getGame();
+    if(!_pause && game.getPhase() != GameState::MENU && !game.isOver())
+        duration += alpha * (_time - _previousTime);
+
+    uint32_t shown = duration / 1000000 * 1000;
+    if(game.getPhase() == GameState::MENU || shown == _shownDuration)
+        return;
+
+    // Timer text changes rebuild its texture, not a steady frame.
+    _shownDuration = shown;
+    this->updateTimer();
+    _quietFrames = 0;
+}
+
+bool Memory::render()
+{
+    bool ok = Node::render();
+
+    // Drawn once per frame, like the tree.
+    ok &= _buttonMouseHandler.highlight();
+    if(this->getGame().getPhase() == GameState::MENU)
+        ok &= _mainMenu->findChild(_mainMenuButtonsNames[_playersNb - 1])->highlight();
+    else
     {
-        uint32_t now = SDL_GetTicks();
-        uint32_t sincePreviousChange = now - _previousTimeChange;
-        if(_pairsFound < _pairs && sincePreviousChange > 1000)
-        {
-            if(_pause)
-                _gameStartTime += sincePreviousChange;
-            else
-            {
-                _gameDuration = now - _gameStartTime;
-                this->updateTimer();
-            }
-            _previousTimeChange = now;
-        }
         for(Player* p : _players)
         {
             if(p->isActive())
-                p->highlight();
+                ok &= p->highlight();
         }
     }
-
-    if(_state == 0)
-    {
-        _mainMenu->findChild(_mainMenuButtonsNames[_playersNb - 1])->highlight();
-    }
+    return ok;
 }
 
 std::string Memory::ticksToString(uint32_t ticks)
@@ -372,7 +413,7 @@ void Memory::updateTimer()
 {
     TextField* timer = (TextField*)this->findChild("timer", true);
     if(timer != nullptr)
-        timer->setText(this->ticksToString(_gameDuration));
+        timer->setText(this->ticksToString(_shownDuration));
 }
 
 void Memory::updateRecord()
@@ -392,27 +433,6 @@ void Memory::updateRecord()
         record->setVisible(false);
 }
 
-Player* Memory::getActivePlayer()
-{
-    for(Player* p : _players)
-        if(p->isActive()) return p;
-    return nullptr;
-}
-
-Player* Memory::getNextPlayer()
-{
-    bool found = false;
-    for(Player* p : _players)
-    {
-        if(found) return p;
-        if(p->isActive()) found = true;
-    }
-    if(found)
-        return _players[0];
-    else
-        return nullptr;
-}
-
 bool Memory::getQuit()
 {
     return _quit;
@@ -494,6 +514,13 @@ bool Memory::changePairs(int offset)
     return true;
 }
 
+int Memory::bigPairsStep(bool increase)
+{
+    if(_pairs < 100 || (!increase && _pairs == 100))
+        return 10;
+    return 100;
+}
+
 bool Memory::incPairs(Node* n)
 {
     (void) n;
@@ -508,7 +535,7 @@ bool Memory::incPairs(Node* n)
 bool Memory::incPairs10(Node* n)
 {
     (void) n;
-    if(this->changePairs(10))
+    if(this->changePairs(this->bigPairsStep(true)))
     {
         logInfo("[Memory] Increased pairs to " + std::to_string(_pairs));
         return true;
@@ -530,7 +557,7 @@ bool Memory::decPairs(Node* n)
 bool Memory::decPairs10(Node* n)
 {
     (void) n;
-    if(this->changePairs(-10))
+    if(this->changePairs(-this->bigPairsStep(false)))
     {
         logInfo("[Memory] Decreased pairs to " + std::to_string(_pairs));
         return true;
@@ -557,13 +584,15 @@ bool Memory::start(Node* n)
         return false;
 
     this->_mainMenu->setVisible(false);
+    ++_resets;
+    _gameDuration = 0;
+    _shownDuration = 0;
     this->createPairs();
 
-    _players[0]->setActive(true);
-
-    _gameStartTime = SDL_GetTicks();
-
-    _state = 1;
+    // Allow zooming until cards are twice their texture size.
+    CardStore* store = _board->getStore();
+    float cardWidth = store->size() > 0 ? store->getRect(0).w : Card::getCardWidth();
+    _board->resetCamera(2.0f * Card::getCardWidth() / cardWidth);
 
     return true;
 }
@@ -579,32 +608,24 @@ bool Memory::newGame(Node* n)
     bool ok = true;
     this->_mainMenu->setVisible(true);
 
-    for(auto node : this->_gameMenu->getChildren())
-    {
-        if(node->isClickable())
-            ok &= _buttonMouseHandler.removeSubscriber(node);
-    }
-
+    // Its buttons leave the mouse handler when deleted.
     ok &= this->removeChild("game_menu", true);
 
-    for(Node* node : _board->getChildren())
-    {
-        this->removeCard((Card*)node);
-    }
+    _board->getStore()->clear();
+    _board->getTweens()->clear();
 
-    // If we are at state 3 or 4 the board is still clickacle.
+    // If two cards are revealed the board is still clickacle.
     _board->setClickable(false);
+    _board->resetCamera();
+    _panning = false;
 
     if(_playersNb == 1)
         this->updateRecord();
 
-    _pickedCard.clear();
     _players.clear();
 
-    _gameStartTime =0;
-    _previousTimeChange = 0;
-    _pairsFound = 0;
-    _state = 0;
+    _gameThread->push(GameCommand::menu());
+    ++_resets;
 
     return ok;
 }
@@ -623,91 +644,89 @@ bool Memory::buttonQuit(Node* n)
 
 
 //====================
-// State functions
+// Game rules
 //====================
 
-void Memory::state1(Card* clicked)
+bool Memory::play(GameAction action)
 {
-    clicked->flip();
-    clicked->setClickable(false);
-    _revealedCards.first = clicked;
-    _state = 2;
-    logInfo("[Memory] Entering state 2.");
+    _gameThread->push(GameCommand::play(action));
+    return true;
 }
 
-void Memory::state2(Card* clicked)
+void Memory::syncGame()
 {
-    clicked->flip();
-    _revealedCards.second = clicked;
-    _revealedCards.first->setClickable(true);
-    _board->setClickable(true);
-    if(_revealedCards.first->getKey() == clicked->getKey())
+    const GameThread::Snapshot& snapshot = _gameThread->getSnapshot();
+
+    // The board already holds the next deal.
+    if(snapshot.resets != _resets)
+        return;
+
+    const GameState& game = snapshot.game;
+
+    // Ignored clicks flip nothing and are not measured.
+    if(_pendingInput != 0 && snapshot.processed >= _pendingInputCommand)
     {
-        Player* p = this->getActivePlayer();
-        if(p == nullptr)
-        {
-            logError("[Memory] No active player !");
-            this->quit();
-            return;
-        }
-        p->incScore();
-        ++_pairsFound;
-        
-        if(_playersNb == 1 && _pairsFound == _pairs && (_gameDuration < _highScores[_pairs] || _highScores[_pairs] == 0))
-        {
-            _highScores[_pairs] = _gameDuration;
-            this->save();
-            this->updateTimer();
-        }
-        
-        _state = 4;
-        logInfo("[Memory] Entering state 4.");
+        if(snapshot.steps != _syncedSteps)
+            _renderer->markInput(&_inputLatency, _pendingInput);
+        _pendingInput = 0;
     }
-    else // No pair found.
-    {
-        Player* p = this->getActivePlayer();
-        Player* np = this->getNextPlayer();
 
-        if(p == nullptr)
-        {
-            logError("[Memory] No active player.");
-            this->quit();
-            return;
-        }
+    if(snapshot.steps != _syncedSteps)
+    {
+        _syncedSteps = snapshot.steps;
 
-        if(np == nullptr)
+        // Several actions may have been applied since the last snapshot.
+        CardStore* store = _board->getStore();
+        TweenSet* tweens = _board->getTweens();
+        for(uint32_t i = 0 ; i < game.getCards() && i < store->size() ; ++i)
         {
-            logError("[Memory] Failed to get next player.");
-            this->quit();
-            return;
+            // Vanishing cards keep their face until they leave the store.
+            if(store->isRemoved(i) || tweens->isRunning(i, TweenSet::VANISH))
+                continue;
+            if(store->isRevealed(i) != game.isRevealed(i) || game.isRemoved(i))
+                this->syncCard(i);
         }
+        this->syncPlayers();
+        logInfo("[Memory] Entering state " + std::to_string(game.getPhase()) + ".");
+    }
 
-        p->setActive(false);
-        np->setActive(true);
+    // Shown by interpolate(), between updates.
+    _gameDuration = snapshot.duration;
 
-        _state = 3;
-        logInfo("[Memory] Entering state 3.");
-    }
+    if(snapshot.record != 0 && game.getPairs() < _highScores.size())
+        _highScores[game.getPairs()] = snapshot.record;
 }
 
-void Memory::state3()
+void Memory::syncCard(int index)
 {
-    _revealedCards.first->flip();
-    _revealedCards.second->flip();
-    _revealedCards = { nullptr, nullptr };
-    _board->setClickable(false);
-    _state = 1;
-    logInfo("[Memory] Entering state 1.");
+    if(index < 0)
+        return;
+
+    const GameState& game = this->getGame();
+    CardStore* store = _board->getStore();
+    if(game.isRemoved(index))
+        this->removeCard(index);
+    else if(store->isRevealed(index) != game.isRevealed(index))
+    {
+        store->setRevealed(index, game.isRevealed(index));
+        _board->getTweens()->start(index, TweenSet::FLIP, _flipDuration);
+    }
+    _board->markDirty();
 }
 
-void Memory::state4()
+void Memory::syncPlayers()
 {
-    this->removeCard(_revealedCards.first);
-    this->removeCard(_revealedCards.second);
-    _revealedCards = { nullptr, nullptr };
-    _board->setClickable(false);
-    _state = 1;
-    logInfo("[Memory] Entering state 1.");
+    const GameState& game = this->getGame();
+    for(size_t i = 0 ; i < _players.size() ; ++i)
+    {
+        Player* p = _players[i];
+        if(p->getScore() != game.getScore(i))
+            p->setScore(game.getScore(i));
+
+        bool active = i == game.getActivePlayer();
+        if(p->isActive() != active)
+            p->setActive(active);
+    }
 }
 
 
@@ -717,12 +736,55 @@ void Memory::state4()
 
 void Memory::eventHandler(SDL_Event event)
 {
+    Watchdog::Zone zone("Memory::eventHandler");
+    if(event.type != SDL_MOUSEMOTION || _panning)
+        _active = true;
+
+    if(event.type == SDL_MOUSEMOTION)
+    {
+        // Relative motion is taken from the cursor, not xrel,
+        // so that recorded motions drag the same way.
+        if(_panning)
+            _board->pan(event.motion.x - _cursor.x, event.motion.y - _cursor.y);
+        _cursor.x = event.motion.x;
+        _cursor.y = event.motion.y;
+    }
+    else if(event.type == SDL_MOUSEBUTTONDOWN || event.type == SDL_MOUSEBUTTONUP)
+    {
+        _cursor.x = event.button.x;
+        _cursor.y = event.button.y;
+    }
+
+    // Games share the window, clicks and keys belong to the game under the cursor.
+    // Escape closes the window, so every game.
+    SDL_Rect area = this->getGlobalDestination();
+    bool targeted = event.type == SDL_MOUSEBUTTONDOWN ||
+        (event.type == SDL_KEYDOWN && event.key.keysym.sym != SDLK_ESCAPE);
+    if(targeted && !SDL_PointInRect(&_cursor, &area))
+        return;
+
+    if(event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_MIDDLE)
+    {
+        SDL_Rect board = _board->getGlobalDestination();
+        _panning = this->getGame().getPhase() != GameState::MENU && SDL_PointInRect(&_cursor, &board);
+    }
+    else if(event.type == SDL_MOUSEBUTTONUP && event.button.button == SDL_BUTTON_MIDDLE)
+        _panning = false;
+    else if(event.type == SDL_MOUSEWHEEL && this->getGame().getPhase() != GameState::MENU)
+    {
+        SDL_Rect board = _board->getGlobalDestination();
+        if(SDL_PointInRect(&_cursor, &board))
+            _board->zoomAt(_cursor, std::pow(1.25f, event.wheel.y));
+    }
+
     if(
         !_pause && event.type == SDL_MOUSEBUTTONDOWN &&
         event.button.button == SDL_BUTTON_LEFT
     )
     {
-        this->click();
+        // No update may have run since the last motion, at high frame rates.
+        this->motion();
+        this->click(event.button.timestamp);
     }
 
     else if(event.type == SDL_MOUSEBUTTONDOWN &&
@@ -743,100 +805,135 @@ void Memory::keypress(int keycode)
 
     else if(keycode == SDLK_SPACE)
         _pause = !_pause;
+
+    else if(keycode == SDLK_F3)
+        this->toggleStats();
 }
 
-void Memory::motion()
+void Memory::toggleStats()
 {
-    _cardMouseHandler.motion();
-    _buttonMouseHandler.motion();
+    if(_stats == nullptr)
+    {
+        _stats = new TextField(_renderer, "textfield_stats", "...");
+        _stats->setLayer(Renderer::LAYER_OVERLAY);
+        this->addChild(_stats);
+        // Shown right away.
+        _statsUpdateTime = _time - _statsPeriod;
+        this->updateStats();
+    }
+    else
+    {
+        this->removeChild(_stats, true);
+        _stats = nullptr;
+    }
 }
 
-bool Memory::click()
+void Memory::updateStats()
 {
-    _cardMouseHandler.click();
-    _buttonMouseHandler.click();
-    return true;
+    // Twice a second, a new text costs a texture.
+    if(_stats == nullptr || _time - _statsUpdateTime < _statsPeriod)
+        return;
+    _statsUpdateTime = _time;
+    _active = true;
+
+    Renderer::FrameStats frame = _renderer->getFrameStats();
+    _stats->setText(
+        "draws " + std::to_string(frame.drawCalls) + "/" + std::to_string(frame.commands) +
+        " | flip " + _inputLatency.summary() +
+        " | tweens " + std::to_string(_board->getTweens()->getRunning()) +
+        " | res " + std::to_string((int)std::round(_renderer->getResolutionScale() * 100)) + "%"
+    );
 }
 
-bool Memory::cardCallback(Node* clicked)
+void Memory::motion()
 {
-    Card* card = (Card*)clicked;
-    if(card == nullptr)
-        return false;
+    _cardMouseHandler.motion(_cursor, _events);
+    _buttonMouseHandler.motion(_cursor, _events);
+}
 
-    logInfo("[Memory] Card " + card->getName() + " clicked.");
-    
-    if(_state == 1)
-    {
-        this->state1(card);
-    }
+bool Memory::click(uint32_t timestamp)
+{
+    bool ok = _cardMouseHandler.click(_events, timestamp);
+    ok &= _buttonMouseHandler.click(_events, timestamp);
+    return ok;
+}
 
-    else if(_state == 2)
+void Memory::handleEvents()
+{
+    if(_events.getDropped() != _droppedEvents)
     {
-        this->state2(card);
+        logWarning("[Memory] " + std::to_string(_events.getDropped() - _droppedEvents) + " events dropped, the queue was full.");
+        _droppedEvents = _events.getDropped();
     }
 
-    else if(_state == 3)
+    // Clicks emitted before a menu change hit buttons
+    // that are gone or hidden, and cards of another deal.
+    bool menuChanged = false;
+    for(const Event& event : _events)
     {
-        this->state3();
-    }
+        if(menuChanged && event.type != Event::HOVER)
+        {
+            logInfo("[Memory] Stale " + std::string(Event::typeName(event.type)) + " event ignored.");
+            continue;
+        }
 
-    else if(_state == 4)
-    {
-        this->state4();
+        if(event.type == Event::CARD_CLICKED)
+            this->cardClicked(event);
+        else if(event.type == Event::BUTTON_PRESSED)
+        {
+            this->buttonPressed(event);
+            menuChanged = event.id == BUTTON_START || event.id == BUTTON_NEW_GAME;
+        }
+        // HOVER : cursor shape and highlight are already handled by the mouse handlers,
+        // and the source may be a button removed by an earlier event.
     }
-    return true;
+    _events.clear();
 }
 
-
-//==========================
-// High scores saving
-//==========================
-
-bool Memory::readSave()
+void Memory::cardClicked(const Event& event)
 {
-    if(std::filesystem::exists(_savePath))
-    {    
-        std::ifstream file(_savePath, std::ios::in | std::ios::binary);
-        if(!file.is_open())
-        {
-            logError("[Memory] Failed to open save file for reading.");
-            return false;
-        }
-        else
-        {
-            uint32_t tmp = 0;
-            for(int i = 0 ; i <= _maxPairs ; ++i)
-            {
-                file.read((char*)&tmp, sizeof(tmp));
-                _highScores.push_back(tmp);
-            }
-            logInfo("[Memory] High scores loaded.");
-            return true;
-        }
+    // Hidden cards still catch clicks, the pair is only hidden
+    // or removed once its flips are over.
+    GameState::Phase phase = this->getGame().getPhase();
+    if((phase == GameState::NO_PAIR || phase == GameState::PAIR_FOUND) && _board->getTweens()->getRunning(TweenSet::FLIP) > 0)
+        return;
+
+    if(event.id >= 0)
+    {
+        Card card(_board->getStore(), event.id);
+        logInfo("[Memory] Card " + card.getName() + " clicked.");
     }
-    else
+
+    // The last snapshot may be behind the actions already pushed,
+    // the game thread knows whether the click picks or acknowledges.
+    this->play(GameAction::click(event.id >= 0 ? event.id : GameAction::noCard));
+
+    // The flip is shown once the game thread applied the action.
+    if(_latencyTracking)
     {
-        for(int i = 0 ; i <= _maxPairs ; ++i)
-            _highScores.push_back(0);
-        logInfo("[Memory] A new high scores file will be created.");
-        return true;
+        _pendingInput = event.timestamp;
+        _pendingInputCommand = _gameThread->getPushed();
     }
 }
 
-bool Memory::save()
+void Memory::buttonPressed(const Event& event)
 {
-    std::ofstream file(_savePath, std::ios::out | std::ios::binary);
-    if(!file.is_open())
-    {
-        logError("[Memory] Failed to open save file for writing.");
-        return false;
-    }
-    else
+    if(event.id < 0 || event.id >= BUTTON_COUNT)
     {
-        for(auto e : _highScores)
-            file.write((char*)&e, sizeof(e));
-        logInfo("[Memory] High scores saved.");
-        return true;
+        logError("[Memory] Unknown button " + std::to_string(event.id) + " pressed.");
+        return;
     }
-}
\ No newline at end of file
+    (this->*_buttonActions[event.id])(event.source);
+}
+
+bool (Memory::* const Memory::_buttonActions[BUTTON_COUNT])(Node*) = {
+    &Memory::onePlayer,
+    &Memory::twoPlayers,
+    &Memory::incPairs,
+    &Memory::incPairs10,
+    &Memory::decPairs,
+    &Memory::decPairs10,
+    &Memory::start,
+    &Memory::newGame,
+    &Memory::buttonQuit
+};
@@ -1,8 +1,6 @@
 #include "MouseHandler.hpp"
 #include "Logger.hpp"
 
-#include <algorithm>
-
 MouseHandler::MouseHandler(SDL_Rect action_area) : _action_area(action_area)
 {
     _normalCursor = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_ARROW);
@@ -12,7 +10,8 @@ MouseHandler::MouseHandler(SDL_Rect action_area) : _action_area(action_area)
 MouseHandler::~MouseHandler()
 {
     _hoveredNode = nullptr;
-    _subscribers.clear();
+    while(_firstSubscriber != nullptr)
+        this->unlinkSubscriber(_firstSubscriber);
 }
 
 bool MouseHandler::addSubscriber(Node* node)
@@ -23,7 +22,20 @@ bool MouseHandler::addSubscriber(Node* node)
         return false;
     }
 
-    _subscribers.push_back(node);
+    if(node->_mouseHandler != nullptr)
+    {
+        logError("[MouseHandler] Cannot add subscriber " + node->getName() + ", already subscribed.");
+        return false;
+    }
+
+    node->_mouseHandler = this;
+    node->_previousSubscriber = _lastSubscriber;
+    node->_nextSubscriber = nullptr;
+    if(_lastSubscriber != nullptr)
+        _lastSubscriber->_nextSubscriber = node;
+    else
+        _firstSubscriber = node;
+    _lastSubscriber = node;
     logInfo("[MouseHandler] Subscriber added : " + node->getName());
     return true;
 }
@@ -36,19 +48,33 @@ bool MouseHandler::removeSubscriber(Node* node)
         return false;
     }
 
-    std::string name = node->getName();
-    auto search = std::find(_subscribers.begin(), _subscribers.end(), node);
-    if(search != _subscribers.end())
-    {
-        _subscribers.erase(search);
-        logInfo("[MouseHandler] Subscriber removed : " + name);
-        return true;
-    }
-    else
+    if(node->_mouseHandler != this)
     {
         logError("[MouseHandler] Cannot remove subscriber " + node->getName() + ", not found.");
         return false;
     }
+
+    this->unlinkSubscriber(node);
+    logInfo("[MouseHandler] Subscriber removed : " + node->getName());
+    return true;
+}
+
+void MouseHandler::unlinkSubscriber(Node* node)
+{
+    if(node->_previousSubscriber != nullptr)
+        node->_previousSubscriber->_nextSubscriber = node->_nextSubscriber;
+    else
+        _firstSubscriber = node->_nextSubscriber;
+    if(node->_nextSubscriber != nullptr)
+        node->_nextSubscriber->_previousSubscriber = node->_previousSubscriber;
+    else
+        _lastSubscriber = node->_previousSubscriber;
+
+    node->_mouseHandler = nullptr;
+    node->_previousSubscriber = nullptr;
+    node->_nextSubscriber = nullptr;
+    if(_hoveredNode == node)
+        _hoveredNode = nullptr;
 }
 
 void MouseHandler::setActionArea(SDL_Rect action_area)
@@ -66,36 +92,27 @@ void MouseHandler::setHighlight(bool highlight)
     _highlight = highlight;
 }
 
-void MouseHandler::motion()
+void MouseHandler::motion(SDL_Point cursor, EventQueue& events)
 {
+    _cursor = cursor;
+    Node* previous = _hoveredNode;
     bool hover = false;
     if(this->isTargeted())
     {
-        SDL_Point cursor_pos = this->getCursorPos();
-        for(auto node : _subscribers)
+        for(Node* node = _firstSubscriber ; node != nullptr ; node = node->_nextSubscriber)
         {
-            SDL_Rect dest = node->getGlobalDestination();
-            if(SDL_PointInRect(&cursor_pos, &dest) && node->isClickable())
+            if(node->hitTest(_cursor))
             {
+                // Not logged, hovering is part of steady frames
+                // that must not allocate.
                 hover = true;
-                if(_hoveredNode != node)
-                {
-                    logInfo("[MouseHandler] Hovering clickable node " + node->getName());
-                    _hoveredNode = node;
-                }
+                _hoveredNode = node;
                 break;
             }
         }
 
         if(hover)
-        {
-            if(_highlight)
-            {
-                SDL_Color color = { 100, 100, 100, 255};
-                _hoveredNode->highlight(color);
-            }
             this->handCursor();
-        }
         else
             this->normalCursor();
     }
@@ -104,9 +121,21 @@ void MouseHandler::motion()
     // even if cursor is not in action area.
     if(!hover)
         _hoveredNode = nullptr;
+
+    if(_hoveredNode != previous)
+        events.push(Event::hover(_hoveredNode, _cursor));
 }
 
-bool MouseHandler::click()
+bool MouseHandler::highlight()
+{
+    if(!_highlight || _hoveredNode == nullptr)
+        return true;
+
+    SDL_Color color = { 100, 100, 100, 255};
+    return _hoveredNode->highlight(color);
+}
+
+bool MouseHandler::click(EventQueue& events, uint32_t timestamp)
 {
     if(this->isTargeted())
     {
@@ -118,7 +147,7 @@ bool MouseHandler::click()
         else
         {
             logInfo("[MouseHandler] " + _hoveredNode->getName() + " clicked.");
-            return _hoveredNode->click();
+            return _hoveredNode->click(events, _cursor, timestamp);
         }
     }
     return true;
@@ -134,15 +163,7 @@ void MouseHandler::handCursor()
     SDL_SetCursor(_handCursor);
 }
 
-SDL_Point MouseHandler::getCursorPos()
-{
-    SDL_Point cursor_pos;
-    SDL_GetMouseState(&cursor_pos.x, &cursor_pos.y);
-    return cursor_pos;
-}
-
 bool MouseHandler::isTargeted()
 {
-    SDL_Point cursor_pos = this->getCursorPos();
-    return SDL_RectEmpty(&_action_area) || SDL_PointInRect(&cursor_pos, &_action_area);
+    return SDL_RectEmpty(&_action_area) || SDL_PointInRect(&_cursor, &_action_area);
 }
\ No newline at end of file
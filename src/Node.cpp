@@ -1,9 +1,12 @@
 #include "Logger.hpp"
+#include "MouseHandler.hpp"
+#include "Watchdog.hpp"
 #include "Node.hpp"
 
-#include <algorithm>
 #include <stdexcept>
 
+size_t Node::_count = 0;
+
 Node::Node(Renderer* renderer, std::string name, SDL_Texture* texture, SDL_Rect destination) : 
     _renderer(renderer),
     _name(name),
@@ -15,14 +18,21 @@ Node::Node(Renderer* renderer, std::string name, SDL_Texture* texture, SDL_Rect
         if(SDL_QueryTexture(_texture, nullptr, nullptr, &_destination.w, &_destination.h) == -1)
             throw std::runtime_error("Failed to query texture for node " + _name);
     }
+    ++_count;
     logInfo("[Node] Instanciated node " + _name);
 }
 
 Node::~Node()
 {
-    for(Node* child : _children)
-        delete child;
-    _children.clear();
+    // Each child unlinks itself.
+    while(_firstChild != nullptr)
+        delete _firstChild;
+    if(_parent != nullptr)
+        _parent->unlinkChild(this);
+    if(_mouseHandler != nullptr)
+        _mouseHandler->removeSubscriber(this);
+    _renderer->destroyTexture(_cacheTexture);
+    --_count;
     logInfo("[Node] Removed node " + _name);
 }
 
@@ -39,9 +49,23 @@ bool Node::addChild(Node* child)
         return false;
     }
 
+    if(child->_parent != nullptr)
+    {
+        logError("[Node] Cannot add child " + child->getName() + " to " + _name + ", it already has a parent.");
+        return false;
+    }
+
     child->setParent(this);
     child->_inTree = true;
-    _children.push_back(child);
+    child->_previousSibling = _lastChild;
+    child->_nextSibling = nullptr;
+    if(_lastChild != nullptr)
+        _lastChild->_nextSibling = child;
+    else
+        _firstChild = child;
+    _lastChild = child;
+    ++_childCount;
+    this->markDirty();
     logInfo("[Node] New child for " + _name + " : " + child->getName());
     return true;
 }
@@ -54,27 +78,38 @@ bool Node::removeChild(Node* child, bool deleteNode)
         return false;
     }
 
-    std::string name = child->getName();
-    auto search = std::find(_children.begin(), _children.end(), child);
-    if(search != _children.end())
+    if(child->_parent != this)
     {
-        Node* child = *search;
-        if(deleteNode)
-            delete child;
-        else
-        {
-            child->setParent(nullptr);
-            child->_inTree = false;
-        }
-        _children.erase(search);
-        logInfo("[Node] Removed child from " + _name + " : " + name);
-        return true;
-    }
-    else
-    {
-        logError("[Node] Cannot remove child " + name + " from " + _name + ", not found.");
+        logError("[Node] Cannot remove child " + child->getName() + " from " + _name + ", not found.");
         return false;
     }
+
+    std::string name = child->getName();
+    if(deleteNode)
+        delete child;
+    else
+        this->unlinkChild(child);
+    logInfo("[Node] Removed child from " + _name + " : " + name);
+    return true;
+}
+
+void Node::unlinkChild(Node* child)
+{
+    if(child->_previousSibling != nullptr)
+        child->_previousSibling->_nextSibling = child->_nextSibling;
+    else
+        _firstChild = child->_nextSibling;
+    if(child->_nextSibling != nullptr)
+        child->_nextSibling->_previousSibling = child->_previousSibling;
+    else
+        _lastChild = child->_previousSibling;
+
+    child->_previousSibling = nullptr;
+    child->_nextSibling = nullptr;
+    child->setParent(nullptr);
+    child->_inTree = false;
+    --_childCount;
+    this->markDirty();
 }
 
 bool Node::removeChild(std::string name, bool deleteNode)
@@ -97,7 +132,7 @@ bool Node::removeChild(std::string name, bool deleteNode)
     }
 }
 
-Node* Node::findChild(std::string name, bool recursive)
+Node* Node::findChild(const std::string& name, bool recursive)
 {
     if(name.empty())
     {
@@ -105,7 +140,7 @@ Node* Node::findChild(std::string name, bool recursive)
         return nullptr;
     }
 
-    for(Node* child : _children)
+    for(Node* child = _firstChild ; child != nullptr ; child = child->_nextSibling)
     {
         if(child->getName() == name)
             return child;
@@ -113,7 +148,7 @@ Node* Node::findChild(std::string name, bool recursive)
 
     if(recursive)
     {
-        for(Node* node : _children)
+        for(Node* node = _firstChild ; node != nullptr ; node = node->_nextSibling)
         {
             Node* result = node->findChild(name, recursive);
             if(result != nullptr)
@@ -131,64 +166,145 @@ Node* Node::findChild(std::string name, bool recursive)
 
 bool Node::render()
 {
+    Watchdog::Zone zone("Node::render");
     if(!this->isVisible())
         return true;
 
+    if(_cached)
+        return this->renderCached();
+    return this->renderTree();
+}
+
+bool Node::renderTree()
+{
     if(_renderer == nullptr)
     {
         logError("[Node] Cannot render texture for node " + _name + ", renderer = nullptr");
         return false;
     }
 
+    // Setters, children and visibility changes all mark the node dirty.
+    if(_dirty)
+    {
+        _displayList.clear();
+        this->flatten(_displayList, this->getDepth());
+        _dirty = false;
+    }
+
+    SDL_Rect visible = _renderer->getVisibleArea();
     bool ok = true;
-    if(_texture != nullptr)
+    for(const DisplayEntry& entry : _displayList)
     {
-        if(this->hasEmptyDestination())
-            ok = _renderer->renderTexture(_texture, nullptr);
-        else if(_parent->isAtOrigin())
-            ok = _renderer->renderTexture(_texture, &_destination);
-        else
+        // Children are laid out inside their own destination,
+        // nothing of a child off screen can be seen.
+        if(!entry.fullTarget && !SDL_HasIntersection(&entry.rect, &visible))
+            continue;
+
+        if(entry.node != nullptr)
         {
-            SDL_Rect dest = this->getGlobalDestination();
-            ok = _renderer->renderTexture(_texture, &dest);
+            if(!entry.node->render())
+                ok = false;
+            continue;
         }
 
-        if(!ok)
-            logError("[Node] Failed to render " + _name);
+        SDL_Rect dest = entry.rect;
+        _renderer->setLayer(entry.layer, entry.depth);
+        if(!_renderer->renderTexture(entry.texture, entry.fullTarget ? nullptr : &dest))
+            ok = false;
     }
 
-    if(!this->renderChildren())
+    if(!ok)
+        logError("[Node] " + _name + " : failed to render one or more nodes.");
+    return ok;
+}
+
+void Node::flatten(std::vector<DisplayEntry>& list, uint16_t depth)
+{
+    if(_texture != nullptr)
+        list.push_back({ _texture, this->getGlobalDestination(), this->hasEmptyDestination(), _layer, depth, nullptr });
+
+    for(Node* child = _firstChild ; child != nullptr ; child = child->_nextSibling)
     {
-        logError("[Node] " + _name + " : failed to render one or more children.");
-        ok = false;
-    }
+        if(!child->_visible)
+            continue;
 
-    return ok;
+        if(child->_cached || !child->_retained)
+            list.push_back({ nullptr, child->getGlobalDestination(), child->hasEmptyDestination(), child->_layer, (uint16_t)(depth + 1), child });
+        else
+            child->flatten(list, depth + 1);
+    }
 }
 
-bool Node::renderChildren()
+bool Node::renderCached()
 {
+    SDL_Rect dest = this->getGlobalDestination();
+    if(SDL_RectEmpty(&dest))
+        dest = { 0, 0, this->getWidth(), this->getHeight() };
+
+    int width = 0;
+    int height = 0;
+    if(_cacheTexture != nullptr)
+        SDL_QueryTexture(_cacheTexture, nullptr, nullptr, &width, &height);
+
+    if(_cacheTexture == nullptr || width != dest.w || height != dest.h)
+    {
+        _renderer->destroyTexture(_cacheTexture);
+        _cacheTexture = _renderer->createBlankRenderTarget(dest.w, dest.h, Renderer::TEXTURE_CACHE);
+        if(_cacheTexture == nullptr)
+        {
+            logError("[Node] Failed to create cache texture for " + _name + ", rendering uncached.");
+            return this->renderTree();
+        }
+        SDL_SetTextureBlendMode(_cacheTexture, SDL_BLENDMODE_BLEND);
+
+        // Rebuilt on the next render if the renderer needs the memory.
+        _renderer->setEvictable(_cacheTexture, [this] {
+            _cacheTexture = nullptr;
+            _dirty = true;
+        });
+        _dirty = true;
+    }
+
     bool ok = true;
-    for(Node* child : _children)
+    if(_dirty)
     {
-        if(!child->render())
-            ok = false;
+        if(!_renderer->beginOffscreen(_cacheTexture, dest))
+        {
+            // Try the cache again next frame.
+            ok = this->renderTree();
+            _dirty = true;
+            return ok;
+        }
+
+        // Clearing leaves the texture transparent.
+        ok = _renderer->clear();
+        ok &= this->renderTree();
+        ok &= _renderer->endOffscreen();
+        _dirty = false;
+    }
+
+    _renderer->touchTexture(_cacheTexture);
+    _renderer->setLayer(_layer, this->getDepth());
+    if(!_renderer->renderTexture(_cacheTexture, &dest))
+    {
+        logError("[Node] Failed to render cache of " + _name);
+        ok = false;
     }
     return ok;
 }
 
-
 //===============
 // Getters
 //===============
 
 Renderer* Node::getRenderer() { return _renderer; }
-std::string Node::getName() { return _name; }
+const std::string& Node::getName() { return _name; }
 SDL_Rect Node::getDestination() { return _destination; }
 int Node::getX() { return _destination.x; }
 int Node::getY() { return _destination.y; }
 SDL_Texture* Node::getTexture() { return _texture; }
-std::vector<Node*> Node::getChildren() { return _children; }
+Node::Children Node::getChildren() { return Children(_firstChild); }
+size_t Node::getChildCount() { return _childCount; }
 Node* Node::getParent() { return _parent; }
 bool Node::isInTree() { return _inTree; }
 bool Node::isClickable() { return Clickable::isClickable() && this->isVisible(); }
@@ -215,7 +331,9 @@ int Node::getHeight()
 
 SDL_Rect Node::getGlobalDestination()
 {
-    if(_parent == nullptr || _parent->isAtOrigin())
+    // The parent may be at its own origin but not its parent,
+    // e.g. in a game placed beside another.
+    if(_parent == nullptr)
         return _destination;
 
     SDL_Rect ret = _destination;
@@ -225,6 +343,12 @@ SDL_Rect Node::getGlobalDestination()
     return ret;
 }
 
+bool Node::hitTest(SDL_Point point)
+{
+    SDL_Rect dest = this->getGlobalDestination();
+    return SDL_PointInRect(&point, &dest) && this->isClickable();
+}
+
 bool Node::isVisible()
 {
 
@@ -246,12 +370,12 @@ void Node::setRenderer(Renderer* renderer)
 }
 
 void Node::setName(std::string name) { _name = name; }
-void Node::setDestination(SDL_Rect dst) { _destination = dst; }
-void Node::setWidth(int width) { _destination.w = width; }
-void Node::setHeight(int height) { _destination.h = height; }
-void Node::setX(int x) { _destination.x = x; }
-void Node::setY(int y) { _destination.y = y; }
-void Node::setTexture(SDL_Texture* texture) { _texture = texture; }
+void Node::setDestination(SDL_Rect dst) { _destination = dst; this->markDirty(); }
+void Node::setWidth(int width) { _destination.w = width; this->markDirty(); }
+void Node::setHeight(int height) { _destination.h = height; this->markDirty(); }
+void Node::setX(int x) { _destination.x = x; this->markDirty(); }
+void Node::setY(int y) { _destination.y = y; this->markDirty(); }
+void Node::setTexture(SDL_Texture* texture) { _texture = texture; this->markDirty(); }
 
 void Node::setSize(int width, int height)
 {
@@ -268,11 +392,44 @@ void Node::setOrigin(int x, int y)
 void Node::setVisible(bool visible)
 {
     _visible = visible;
+    this->markDirty();
     logInfo("[Node] Set visibility of node " + _name + " to " + std::to_string(visible));
 }
 
 void Node::setParent(Node* parent) { _parent = parent; }
 
+void Node::setCached(bool cached)
+{
+    _cached = cached;
+    this->markDirty();
+    if(!_cached)
+    {
+        _renderer->destroyTexture(_cacheTexture);
+        _cacheTexture = nullptr;
+    }
+    logInfo("[Node] Set caching of node " + _name + " to " + std::to_string(cached));
+}
+
+void Node::setLayer(Renderer::Layer layer)
+{
+    _layer = layer;
+    this->markDirty();
+}
+
+uint16_t Node::getDepth()
+{
+    uint16_t depth = 0;
+    for(Node* parent = _parent ; parent != nullptr ; parent = parent->_parent)
+        ++depth;
+    return depth;
+}
+
+void Node::markDirty()
+{
+    for(Node* node = this ; node != nullptr ; node = node->_parent)
+        node->_dirty = true;
+}
+
 
 //===============
 // Others
@@ -289,13 +446,13 @@ void Node::initializeDestination()
 void Node::centerX()
 {
     if(_parent != nullptr)
-        _destination.x = _parent->getWidth() / 2 - _destination.w / 2;
+        this->setX(_parent->getWidth() / 2 - _destination.w / 2);
 }
 
 void Node::centerY()
 {
     if(_parent != nullptr)
-        _destination.y = _parent->getHeight() / 2 - _destination.h / 2;
+        this->setY(_parent->getHeight() / 2 - _destination.h / 2);
 }
 
 bool Node::highlight(SDL_Color color)
@@ -0,0 +1,432 @@
+#include "Recording.hpp"
+#include "Clock.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    const char magic[4] = { 'M', 'R', 'E', 'C' };
+    const uint8_t version = 5;
+
+    enum Tag : uint32_t
+    {
+        TAG_FRAME = 0,
+        TAG_RESULT = 1,
+        TAG_END = 2
+    };
+
+    enum EventType : uint8_t
+    {
+        EVENT_MOTION = 0,
+        EVENT_BUTTON_DOWN = 1,
+        EVENT_KEY_DOWN = 2,
+        EVENT_BUTTON_UP = 3,
+        EVENT_WHEEL = 4
+    };
+
+    void writeVarint(std::vector<uint8_t>& out, uint64_t value)
+    {
+        while(value >= 0x80)
+        {
+            out.push_back((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        out.push_back(value);
+    }
+
+    uint64_t zigzag(int64_t value)
+    {
+        return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    }
+
+    int64_t unzigzag(uint64_t value)
+    {
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    bool readVarint(std::istream& in, uint64_t& value)
+    {
+        value = 0;
+        for(int shift = 0 ; shift < 64 ; shift += 7)
+        {
+            int byte = in.get();
+            if(byte == EOF)
+                return false;
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if(!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    bool readVarint(std::istream& in, uint32_t& value)
+    {
+        uint64_t wide = 0;
+        if(!readVarint(in, wide))
+            return false;
+        value = wide;
+        return true;
+    }
+}
+
+
+//====================
+// Recording
+//====================
+
+bool Recording::GameResult::operator==(const GameResult& other) const
+{
+    return duration == other.duration && turns == other.turns && scores == other.scores;
+}
+
+std::string Recording::GameResult::toString() const
+{
+    std::stringstream text;
+    text << "duration " << std::fixed << std::setprecision(3) << Clock::toMilliseconds(duration) << " ms, " << turns << " turns, scores";
+    for(uint32_t score : scores)
+        text << " " << score;
+    return text.str();
+}
+
+bool Recording::gameFinished(Memory& memory, bool& wasOver, GameResult& result)
+{
+    const GameState& game = memory.getGame();
+    bool over = game.isOver();
+    bool finished = over && !wasOver;
+    wasOver = over;
+    if(!finished)
+        return false;
+
+    result.duration = memory.getGameDuration();
+    result.turns = game.getTurns();
+    result.scores.clear();
+    for(uint32_t i = 0 ; i < game.getPlayers() ; ++i)
+        result.scores.push_back(game.getScore(i));
+    return true;
+}
+
+
+//====================
+// Recorder
+//====================
+
+InputRecorder::InputRecorder() {}
+
+InputRecorder::~InputRecorder()
+{
+    this->close();
+}
+
+bool InputRecorder::open(std::string path, uint32_t seed, int width, int height)
+{
+    _file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!_file.is_open())
+    {
+        logError("[InputRecorder] Failed to open " + path + " for writing.");
+        return false;
+    }
+
+    std::vector<uint8_t> header(magic, magic + sizeof(magic));
+    header.push_back(version);
+    writeVarint(header, seed);
+    writeVarint(header, width);
+    writeVarint(header, height);
+    _file.write((const char*)header.data(), header.size());
+
+    logInfo("[InputRecorder] Recording to " + path + " with seed " + std::to_string(seed) + ".");
+    return true;
+}
+
+void InputRecorder::beginFrame(uint64_t time)
+{
+    _frame.clear();
+    _frameEvents = 0;
+    writeVarint(_frame, time - _previousTime);
+    _previousTime = time;
+}
+
+void InputRecorder::event(const SDL_Event& event)
+{
+    SDL_Point position;
+    if(event.type == SDL_MOUSEMOTION)
+    {
+        _frame.push_back(EVENT_MOTION);
+        position = { event.motion.x, event.motion.y };
+    }
+    else if(event.type == SDL_MOUSEBUTTONDOWN || event.type == SDL_MOUSEBUTTONUP)
+    {
+        _frame.push_back(event.type == SDL_MOUSEBUTTONDOWN ? EVENT_BUTTON_DOWN : EVENT_BUTTON_UP);
+        _frame.push_back(event.button.button);
+        position = { event.button.x, event.button.y };
+    }
+    else if(event.type == SDL_MOUSEWHEEL)
+    {
+        _frame.push_back(EVENT_WHEEL);
+        writeVarint(_frame, zigzag(event.wheel.y));
+        ++_frameEvents;
+        return;
+    }
+    else if(event.type == SDL_KEYDOWN)
+    {
+        _frame.push_back(EVENT_KEY_DOWN);
+        writeVarint(_frame, (uint32_t)event.key.keysym.sym);
+        ++_frameEvents;
+        return;
+    }
+    else
+        return;
+
+    writeVarint(_frame, zigzag(position.x - _cursor.x));
+    writeVarint(_frame, zigzag(position.y - _cursor.y));
+    _cursor = position;
+    ++_frameEvents;
+}
+
+void InputRecorder::endFrame(Memory& memory)
+{
+    if(!_file.is_open())
+        return;
+
+    std::vector<uint8_t> head;
+    writeVarint(head, (_frameEvents << 2) | TAG_FRAME);
+    _file.write((const char*)head.data(), head.size());
+    _file.write((const char*)_frame.data(), _frame.size());
+
+    Recording::GameResult result;
+    if(Recording::gameFinished(memory, _wasOver, result))
+    {
+        std::vector<uint8_t> record;
+        writeVarint(record, (result.scores.size() << 2) | TAG_RESULT);
+        writeVarint(record, result.duration);
+        writeVarint(record, result.turns);
+        for(uint32_t score : result.scores)
+            writeVarint(record, score);
+        _file.write((const char*)record.data(), record.size());
+        logInfo("[InputRecorder] Recorded game result : " + result.toString());
+    }
+}
+
+void InputRecorder::close()
+{
+    if(!_file.is_open())
+        return;
+
+    std::vector<uint8_t> end;
+    writeVarint(end, TAG_END);
+    _file.write((const char*)end.data(), end.size());
+    _file.close();
+    logInfo("[InputRecorder] Recording closed.");
+}
+
+
+//====================
+// Replayer
+//====================
+
+InputReplayer::InputReplayer() {}
+
+InputReplayer::~InputReplayer() {}
+
+bool InputReplayer::open(std::string path)
+{
+    _file.open(path, std::ios::in | std::ios::binary);
+    if(!_file.is_open())
+    {
+        logError("[InputReplayer] Failed to open " + path + " for reading.");
+        return false;
+    }
+
+    char fileMagic[sizeof(magic)];
+    _file.read(fileMagic, sizeof(fileMagic));
+    int fileVersion = _file.get();
+    uint32_t width = 0;
+    uint32_t height = 0;
+    if(!_file || !std::equal(magic, magic + sizeof(magic), fileMagic) || fileVersion != version ||
+        !readVarint(_file, _seed) || !readVarint(_file, width) || !readVarint(_file, height))
+    {
+        logError("[InputReplayer] " + path + " is not a valid recording.");
+        return false;
+    }
+    _width = width;
+    _height = height;
+
+    logInfo("[InputReplayer] Replaying " + path + " with seed " + std::to_string(_seed) + ".");
+    return true;
+}
+
+bool InputReplayer::frame(Memory& memory, bool realtime)
+{
+    if(_ended)
+        return false;
+
+    uint32_t head = 0;
+    while(true)
+    {
+        if(!readVarint(_file, head))
+        {
+            logError("[InputReplayer] Recording ends without end marker.");
+            _corrupted = true;
+            _ended = true;
+            return false;
+        }
+
+        uint32_t tag = head & 3;
+        uint32_t count = head >> 2;
+        if(tag == TAG_FRAME)
+            break;
+
+        if(tag == TAG_END)
+        {
+            _ended = true;
+            return false;
+        }
+
+        Recording::GameResult result;
+        result.scores.resize(count);
+        bool ok = tag == TAG_RESULT && readVarint(_file, result.duration) && readVarint(_file, result.turns);
+        for(uint32_t i = 0 ; ok && i < count ; ++i)
+            ok = readVarint(_file, result.scores[i]);
+        if(!ok)
+        {
+            logError("[InputReplayer] Corrupted record in recording.");
+            _corrupted = true;
+            _ended = true;
+            return false;
+        }
+        _expected.push_back(result);
+        this->compare();
+    }
+
+    uint64_t delta = 0;
+    if(!readVarint(_file, delta))
+    {
+        _corrupted = true;
+        _ended = true;
+        return false;
+    }
+    _time += delta;
+
+    if(_frames == 0)
+    {
+        _firstTime = _time;
+        _start = Clock::now();
+    }
+    else if(realtime)
+    {
+        uint64_t elapsed = Clock::now() - _start;
+        uint64_t target = _time - _firstTime;
+        if(target > elapsed)
+            SDL_Delay((target - elapsed) / 1000);
+    }
+
+    uint32_t events = head >> 2;
+    for(uint32_t i = 0 ; i < events ; ++i)
+    {
+        SDL_Event event = SDL_Event();
+        int type = _file.get();
+        uint64_t value = 0;
+        uint64_t dx = 0;
+        uint64_t dy = 0;
+        bool ok = true;
+
+        if(type == EVENT_KEY_DOWN)
+        {
+            ok = readVarint(_file, value);
+            event.type = SDL_KEYDOWN;
+            event.key.state = SDL_PRESSED;
+            event.key.keysym.sym = (SDL_Keycode)value;
+        }
+        else if(type == EVENT_WHEEL)
+        {
+            ok = readVarint(_file, value);
+            event.type = SDL_MOUSEWHEEL;
+            event.wheel.y = unzigzag(value);
+        }
+        else if(type == EVENT_MOTION || type == EVENT_BUTTON_DOWN || type == EVENT_BUTTON_UP)
+        {
+            int button = type == EVENT_MOTION ? 0 : _file.get();
+            ok = button != EOF && readVarint(_file, dx) && readVarint(_file, dy);
+            _cursor.x += unzigzag(dx);
+            _cursor.y += unzigzag(dy);
+
+            if(type == EVENT_MOTION)
+            {
+                event.type = SDL_MOUSEMOTION;
+                event.motion.x = _cursor.x;
+                event.motion.y = _cursor.y;
+            }
+            else
+            {
+                bool down = type == EVENT_BUTTON_DOWN;
+                event.type = down ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+                event.button.button = button;
+                event.button.state = down ? SDL_PRESSED : SDL_RELEASED;
+                event.button.x = _cursor.x;
+                event.button.y = _cursor.y;
+            }
+        }
+        else
+            ok = false;
+
+        if(!ok)
+        {
+            logError("[InputReplayer] Corrupted event in recording.");
+            _corrupted = true;
+            _ended = true;
+            return false;
+        }
+
+        event.common.timestamp = _time / 1000;
+        memory.eventHandler(event);
+    }
+
+    ++_frames;
+    return true;
+}
+
+void InputReplayer::endFrame(Memory& memory)
+{
+    Recording::GameResult result;
+    if(Recording::gameFinished(memory, _wasOver, result))
+    {
+        _actual.push_back(result);
+        this->compare();
+    }
+}
+
+void InputReplayer::compare()
+{
+    for(; _checked < _expected.size() && _checked < _actual.size() ; ++_checked)
+    {
+        const Recording::GameResult& expected = _expected[_checked];
+        const Recording::GameResult& actual = _actual[_checked];
+        if(expected == actual)
+            continue;
+
+        ++_mismatches;
+        logError("[InputReplayer] Game " + std::to_string(_checked + 1) + " differs. Recorded : " + expected.toString() + ". Replayed : " + actual.toString() + ".");
+    }
+}
+
+int InputReplayer::finish()
+{
+    this->compare();
+    std::cout << "Replay : " << _frames << " frames, "
+        << _actual.size() << "/" << _expected.size() << " games replayed, "
+        << _mismatches << " mismatches" << std::endl;
+
+    for(size_t i = 0 ; i < _actual.size() ; ++i)
+        std::cout << "  game " << i + 1 << " : " << _actual[i].toString() << std::endl;
+
+    if(_corrupted || _mismatches > 0 || _actual.size() != _expected.size())
+    {
+        std::cout << "FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
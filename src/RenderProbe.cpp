@@ -0,0 +1,216 @@
+#include "RenderProbe.hpp"
+#include "Card.hpp"
+#include "Clock.hpp"
+#include "Logger.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+int RenderProbe::selectDriver(SDL_Window* window, const std::string& requested)
+{
+    if(requested == defaultDriver)
+        return -1;
+
+    if(!requested.empty() && requested != probeDriver)
+    {
+        int index = RenderProbe::driverIndex(requested);
+        if(index < 0)
+            logWarning("[RenderProbe] Render driver " + requested + " is not available, SDL chooses.");
+        return index;
+    }
+
+    std::string key = RenderProbe::machineKey();
+    std::vector<Result> results;
+    if(requested == probeDriver || !RenderProbe::readCache(key, results))
+    {
+        logInfo("[RenderProbe] Timing render drivers on " + key + ".");
+        results = RenderProbe::run(window);
+        RenderProbe::writeCache(key, results);
+    }
+
+    int chosen = RenderProbe::fastest(results);
+    RenderProbe::logResults(results, chosen);
+    return chosen < 0 ? -1 : RenderProbe::driverIndex(results[chosen].driver);
+}
+
+std::vector<RenderProbe::Result> RenderProbe::run(SDL_Window* window)
+{
+    std::vector<Result> results;
+    int count = SDL_GetNumRenderDrivers();
+    for(int index = 0 ; index < count ; ++index)
+    {
+        SDL_RendererInfo info;
+        if(SDL_GetRenderDriverInfo(index, &info) != 0)
+            continue;
+        results.push_back({ info.name, RenderProbe::timeDriver(window, index) });
+    }
+    return results;
+}
+
+std::string RenderProbe::machineKey()
+{
+    // SDL gives no GPU name without a GL context,
+    // the display and the drivers available stand for it.
+    const char* video = SDL_GetCurrentVideoDriver();
+    const char* display = SDL_GetDisplayName(0);
+    std::string key = std::string(video == nullptr ? "unknown" : video) + "/" + (display == nullptr ? "unknown" : display) + "/";
+    int count = SDL_GetNumRenderDrivers();
+    for(int index = 0 ; index < count ; ++index)
+    {
+        SDL_RendererInfo info;
+        if(SDL_GetRenderDriverInfo(index, &info) == 0)
+            key += (index > 0 ? "," : "") + std::string(info.name);
+    }
+
+    // One line per result in the cache.
+    for(char& c : key)
+    {
+        if(c == '\t' || c == '\n' || c == '\r')
+            c = ' ';
+    }
+    return key;
+}
+
+int RenderProbe::driverIndex(const std::string& name)
+{
+    int count = SDL_GetNumRenderDrivers();
+    for(int index = 0 ; index < count ; ++index)
+    {
+        SDL_RendererInfo info;
+        if(SDL_GetRenderDriverInfo(index, &info) == 0 && name == info.name)
+            return index;
+    }
+    return -1;
+}
+
+double RenderProbe::timeDriver(SDL_Window* window, int index)
+{
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, index, 0);
+    if(renderer == nullptr)
+    {
+        logWarning("[RenderProbe] Failed to create renderer " + std::to_string(index) + " : " + SDL_GetError());
+        return -1;
+    }
+
+    // A plain card, the copies cost the same whatever the pixels.
+    int cardWidth = Card::getCardWidth();
+    int cardHeight = Card::getCardHeight();
+    std::vector<uint32_t> pixels(cardWidth * cardHeight, 0xf0f0f0ff);
+    SDL_Texture* card = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, cardWidth, cardHeight);
+    if(card == nullptr || SDL_UpdateTexture(card, nullptr, pixels.data(), cardWidth * sizeof(uint32_t)) != 0)
+    {
+        logWarning("[RenderProbe] Failed to create the card texture on renderer " + std::to_string(index) + ".");
+        if(card != nullptr)
+            SDL_DestroyTexture(card);
+        SDL_DestroyRenderer(renderer);
+        return -1;
+    }
+    SDL_SetTextureBlendMode(card, SDL_BLENDMODE_BLEND);
+
+    // A full board of cards over a background, like the biggest game.
+    int width = 0;
+    int height = 0;
+    SDL_GetWindowSize(window, &width, &height);
+    std::vector<SDL_Rect> cards;
+    for(int y = 0 ; y + cardHeight <= height ; y += cardHeight + cardHeight / 10)
+    {
+        for(int x = 0 ; x + cardWidth <= width ; x += cardWidth + cardWidth / 10)
+            cards.push_back({ x, y, cardWidth, cardHeight });
+    }
+
+    uint64_t start = 0;
+    for(int frame = 0 ; frame < _warmupFrames + _timedFrames ; ++frame)
+    {
+        if(frame == _warmupFrames)
+            start = Clock::now();
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, card, nullptr, nullptr);
+        for(const SDL_Rect& rect : cards)
+            SDL_RenderCopy(renderer, card, nullptr, &rect);
+        SDL_RenderPresent(renderer);
+    }
+    double ms = Clock::toMilliseconds(Clock::now() - start) / _timedFrames;
+
+    SDL_DestroyTexture(card);
+    SDL_DestroyRenderer(renderer);
+    return ms;
+}
+
+bool RenderProbe::readCache(const std::string& key, std::vector<Result>& results)
+{
+    results.clear();
+    std::ifstream file(cachePath, std::ios::in);
+    if(!file.is_open())
+        return false;
+
+    // key \t driver \t frame ms
+    std::string line;
+    while(std::getline(file, line))
+    {
+        size_t driverStart = line.find('\t');
+        size_t msStart = driverStart == std::string::npos ? std::string::npos : line.find('\t', driverStart + 1);
+        if(msStart == std::string::npos || line.compare(0, driverStart, key) != 0)
+            continue;
+        std::string driver = line.substr(driverStart + 1, msStart - driverStart - 1);
+        results.push_back({ driver, std::strtod(line.c_str() + msStart + 1, nullptr) });
+    }
+    return !results.empty();
+}
+
+bool RenderProbe::writeCache(const std::string& key, const std::vector<Result>& results)
+{
+    // Keep the results of other machines sharing the directory.
+    std::vector<std::string> others;
+    std::ifstream previous(cachePath, std::ios::in);
+    std::string line;
+    while(previous.is_open() && std::getline(previous, line))
+    {
+        if(line.compare(0, key.size() + 1, key + '\t') != 0)
+            others.push_back(line);
+    }
+    previous.close();
+
+    std::ofstream file(cachePath, std::ios::out | std::ios::trunc);
+    if(!file.is_open())
+    {
+        logError("[RenderProbe] Failed to open " + std::string(cachePath) + " for writing.");
+        return false;
+    }
+    for(const std::string& other : others)
+        file << other << std::endl;
+    for(const Result& result : results)
+        file << key << '\t' << result.driver << '\t' << result.frameMs << std::endl;
+    return true;
+}
+
+int RenderProbe::fastest(const std::vector<Result>& results)
+{
+    int chosen = -1;
+    for(size_t i = 0 ; i < results.size() ; ++i)
+    {
+        // A cached driver may be gone since.
+        if(results[i].frameMs < 0 || RenderProbe::driverIndex(results[i].driver) < 0)
+            continue;
+        if(chosen < 0 || results[i].frameMs < results[chosen].frameMs)
+            chosen = i;
+    }
+    return chosen;
+}
+
+void RenderProbe::logResults(const std::vector<Result>& results, int chosen)
+{
+    for(size_t i = 0 ; i < results.size() ; ++i)
+    {
+        std::stringstream line;
+        if(results[i].frameMs < 0)
+            line << "failed";
+        else
+            line << std::fixed << std::setprecision(2) << results[i].frameMs << " ms per frame";
+        logInfo("[RenderProbe] " + results[i].driver + " : " + line.str() + ((int)i == chosen ? ", chosen." : "."));
+    }
+    if(chosen < 0)
+        logWarning("[RenderProbe] No render driver worked in the probe, SDL chooses.");
+}
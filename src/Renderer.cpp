@@ -1,5 +1,11 @@
 #include "Renderer.hpp"
+#include "Clock.hpp"
 #include "Logger.hpp"
+#include "RenderProbe.hpp"
+#include "Watchdog.hpp"
+
+#include <algorithm>
+#include <cmath>
 
 Renderer::Renderer()
 {}
@@ -7,19 +13,24 @@ Renderer::Renderer()
 Renderer::~Renderer()
 {}
 
-bool Renderer::init()
+bool Renderer::init(StartupProfile* startup, const std::string& driver)
 {
-    if(SDL_Init(SDL_INIT_EVERYTHING) < 0)
+    // Video brings up events too.
+    if(SDL_Init(SDL_INIT_VIDEO) < 0)
     {
         logError("[Renderer] Failed to initialize SDL.");
         return false;
     }
+    if(startup != nullptr)
+        startup->mark("sdl init");
 
     if(TTF_Init() != 0)
     {
         logError("[Renderer] Failed to initialize TTF.");
         return false;
     }
+    if(startup != nullptr)
+        startup->mark("ttf init");
 
     if(!getScreenSize())
     {
@@ -46,17 +57,31 @@ bool Renderer::init()
         logError("[Renderer] Failed to create window.");
         return false;
     }
+    if(startup != nullptr)
+        startup->mark("window");
+
+    int driverIndex = RenderProbe::selectDriver(_window, driver);
+    if(startup != nullptr)
+        startup->mark("render probe");
 
+    // A chosen driver may be a software one.
     _renderer = SDL_CreateRenderer(
         _window,
-        -1,
-        SDL_RENDERER_ACCELERATED
+        driverIndex,
+        driverIndex < 0 ? SDL_RENDERER_ACCELERATED : 0
     );
     if(_renderer == nullptr)
     {
         logError("[Renderer] Failed to create renderer.");
         return false;
     }
+    if(startup != nullptr)
+        startup->mark("renderer");
+
+    // The recording list takes turns with the two frame lists.
+    _commands.reserve(_reservedCommands);
+    reserve(_frames[0], _reservedCommands);
+    reserve(_frames[1], _reservedCommands);
 
     logInfo("[Renderer] Init done.");
     return true;
@@ -64,6 +89,21 @@ bool Renderer::init()
 
 void Renderer::stop()
 {
+    _worker.wait();
+    _commands.clear();
+    _frames[0] = Frame();
+    _frames[1] = Frame();
+    _offscreens.clear();
+
+    this->releaseTextures(UINT64_MAX);
+
+    // Freed by SDL with the renderer.
+    _resolution = DynamicResolution();
+    _textures.clear();
+    for(TextureMemory& memory : _textureMemory)
+        memory.bytes = memory.textures = 0;
+    _totalTextureMemory.bytes = _totalTextureMemory.textures = 0;
+
     SDL_DestroyRenderer(_renderer);
     _renderer = nullptr;
 
@@ -75,7 +115,86 @@ void Renderer::stop()
 
 void Renderer::refresh()
 {
+    Watchdog::Zone zone("Renderer::refresh");
+    // The worker is done with the frame recorded by the previous call.
+    _worker.wait();
+    Frame& previous = _frames[_preparing];
+    Frame& next = _frames[1 - _preparing];
+    next.commands.swap(_commands);
+    _commands.clear();
+    next.inputs = _inputs;
+    _inputs = MarkedInputs();
+
+    // Sorting and batching of this frame overlap the submission of the previous one.
+    bool ok = true;
+    bool scaled = _resolution.target != nullptr;
+    uint64_t start = Clock::now();
+    if(scaled)
+        ok = this->beginScaledFrame();
+    if(_pipelined)
+    {
+        _worker.submit([&next] { Renderer::prepare(next); });
+        ok &= this->submit(previous);
+        _frameStats = previous.stats;
+        _preparing = 1 - _preparing;
+    }
+    else
+    {
+        // A frame left over from pipelining is shown first.
+        if(!previous.batches.empty())
+            ok &= this->submit(previous);
+        Renderer::prepare(next);
+        ok &= this->submit(next);
+        _frameStats = next.stats;
+        for(size_t i = 0 ; i < next.inputs.count ; ++i)
+            previous.inputs.add(next.inputs.inputs[i].histogram, next.inputs.inputs[i].timestamp);
+        next.inputs = MarkedInputs();
+    }
+    if(scaled)
+        ok &= this->endScaledFrame();
+    if(!ok)
+        logError("[Renderer] Failed to submit one or more draws.");
     SDL_RenderPresent(_renderer);
+    ++_frameIndex;
+    this->releaseTextures(_frameIndex);
+    if(scaled)
+        this->adaptResolution(Clock::toMilliseconds(Clock::now() - start));
+
+    // Previous is the frame just presented in both modes.
+    if(previous.inputs.count > 0)
+    {
+        uint32_t now = SDL_GetTicks();
+        for(size_t i = 0 ; i < previous.inputs.count ; ++i)
+        {
+            const MarkedInputs::Input& input = previous.inputs.inputs[i];
+            if(now >= input.timestamp)
+                input.histogram->record(now - input.timestamp);
+        }
+        previous.inputs = MarkedInputs();
+    }
+
+    _frameStats.commands += _stats.commands;
+    _frameStats.drawCalls += _stats.drawCalls;
+    _frameStats.textureSwitches += _stats.textureSwitches;
+    _stats = FrameStats();
+}
+
+void Renderer::markInput(LatencyHistogram* histogram, uint32_t timestamp)
+{
+    if(histogram != nullptr && timestamp != 0)
+        _inputs.add(histogram, timestamp);
+}
+
+void Renderer::setPipelined(bool pipelined)
+{
+    _pipelined = pipelined;
+    logInfo("[Renderer] Set pipelining to " + std::to_string(pipelined));
+}
+
+void Renderer::setLayer(Layer layer, uint16_t depth)
+{
+    _layer = layer;
+    _depth = depth;
 }
 
 bool Renderer::clear()
@@ -126,6 +245,348 @@ bool Renderer::setViewport(SDL_Rect* rect)
     return true;
 }
 
+bool Renderer::setClipRect(SDL_Rect* rect)
+{
+    SDL_Rect moved;
+    SDL_Rect* clip = this->toTarget(rect, moved);
+    _hasClip = clip != nullptr;
+    if(_hasClip)
+        _clip = *clip;
+    return true;
+}
+
+bool Renderer::setScale(float scale)
+{
+    if(scale <= 0)
+    {
+        logError("[Renderer] Cannot set scale to " + std::to_string(scale) + ".");
+        return false;
+    }
+
+    if(SDL_RenderSetScale(_renderer, scale, scale) == -1)
+    {
+        logError("[Renderer] Failed to set scale.");
+        return false;
+    }
+    _scale = scale;
+    logInfo("[Renderer] Set scale to " + std::to_string(scale));
+    return true;
+}
+
+bool Renderer::setDynamicResolution(float targetMs, float minScale)
+{
+    if(targetMs <= 0)
+    {
+        this->destroyTexture(_resolution.target);
+        _resolution = DynamicResolution();
+        logInfo("[Renderer] Dynamic resolution disabled.");
+        return true;
+    }
+
+    if(minScale <= 0 || minScale > 1)
+    {
+        logError("[Renderer] Cannot set minimum resolution scale to " + std::to_string(minScale) + ".");
+        return false;
+    }
+
+    if(_resolution.target == nullptr)
+    {
+        _resolution.target = this->createBlankRenderTarget(_width, _height);
+        if(_resolution.target == nullptr)
+        {
+            logError("[Renderer] Failed to create the dynamic resolution target.");
+            return false;
+        }
+    #if SDL_VERSION_ATLEAST(2, 0, 12)
+        SDL_SetTextureScaleMode(_resolution.target, SDL_ScaleModeLinear);
+    #endif
+    }
+
+    _resolution.targetMs = targetMs;
+    _resolution.minScale = minScale;
+    _resolution.scale = std::max(_resolution.scale, minScale);
+    logInfo("[Renderer] Dynamic resolution holding " + std::to_string(targetMs) + " ms per frame, down to " + std::to_string(minScale) + ".");
+    return true;
+}
+
+bool Renderer::beginScaledFrame()
+{
+    // A texture target resets the scale, it is set again for the internal resolution.
+    float scale = _scale * _resolution.scale;
+    if(!this->setRenderTarget(_resolution.target))
+        return false;
+    if(SDL_RenderSetScale(_renderer, scale, scale) == -1)
+    {
+        logError("[Renderer] Failed to set the dynamic resolution scale.");
+        return false;
+    }
+    return this->clear();
+}
+
+bool Renderer::endScaledFrame()
+{
+    if(!this->setRenderTarget(nullptr))
+        return false;
+    SDL_Rect used = { 0, 0, (int)std::ceil(_width * _resolution.scale), (int)std::ceil(_height * _resolution.scale) };
+    return this->copy(_resolution.target, nullptr, &used);
+}
+
+void Renderer::adaptResolution(double ms)
+{
+    _resolution.smoothedMs = _resolution.smoothedMs == 0 ? ms : _resolution.smoothedMs * 0.9 + ms * 0.1;
+    if(++_resolution.framesSinceChange < _resolutionSettleFrames)
+        return;
+
+    // Going up waits for a wide margin, or it would go back and forth.
+    float scale = _resolution.scale;
+    if(_resolution.smoothedMs > _resolution.targetMs)
+        scale = std::max(_resolution.minScale, scale - 0.1f);
+    else if(_resolution.smoothedMs < _resolution.targetMs * 0.6)
+        scale = std::min(1.0f, scale + 0.05f);
+
+    if(scale != _resolution.scale)
+    {
+        _resolution.scale = scale;
+        _resolution.framesSinceChange = 0;
+    }
+}
+
+SDL_Rect Renderer::getVisibleArea()
+{
+    if(!_offscreens.empty())
+        return _offscreens.back().area;
+    return { 0, 0, (int)(_width / _scale), (int)(_height / _scale) };
+}
+
+bool Renderer::beginOffscreen(SDL_Texture* texture, SDL_Rect area)
+{
+    if(texture == nullptr)
+    {
+        logError("[Renderer] Cannot render offscreen, texture = nullptr.");
+        return false;
+    }
+
+    SDL_Texture* previous = this->getRenderTarget();
+    if(!this->setRenderTarget(texture))
+        return false;
+    _offscreens.push_back({ previous, area, _commands.size() });
+    return true;
+}
+
+bool Renderer::endOffscreen()
+{
+    if(_offscreens.empty())
+    {
+        logError("[Renderer] Cannot end offscreen rendering, none in progress.");
+        return false;
+    }
+
+    // Draws recorded since the beginning belong to the offscreen texture.
+    Frame& frame = _offscreenFrame;
+    frame.commands.assign(_commands.begin() + _offscreens.back().firstCommand, _commands.end());
+    _commands.resize(_offscreens.back().firstCommand);
+    Renderer::prepare(frame);
+    bool ok = this->submit(frame);
+    _stats.commands += frame.stats.commands;
+    _stats.drawCalls += frame.stats.drawCalls;
+    _stats.textureSwitches += frame.stats.textureSwitches;
+    if(!ok)
+        logError("[Renderer] Failed to submit one or more offscreen draws.");
+
+    SDL_Texture* previous = _offscreens.back().previousTarget;
+    _offscreens.pop_back();
+    return this->setRenderTarget(previous) && ok;
+}
+
+void Renderer::prepare(Frame& frame)
+{
+    std::vector<DrawCommand>& commands = frame.commands;
+    frame.batches.clear();
+    frame.rects.clear();
+    frame.vertices.clear();
+    frame.indices.clear();
+    frame.stats = FrameStats();
+    frame.stats.commands = commands.size();
+
+    // Draws entirely clipped out cost nothing to drop here.
+    commands.erase(std::remove_if(commands.begin(), commands.end(), [](const DrawCommand& command) {
+        return command.hasClip && command.hasDst && !SDL_HasIntersection(&command.dst, &command.clip);
+    }), commands.end());
+
+    // Ties keep the recording order, like a stable sort
+    // but without its temporary buffer.
+    for(size_t i = 0 ; i < commands.size() ; ++i)
+        commands[i].order = i;
+    std::sort(commands.begin(), commands.end(), [](const DrawCommand& a, const DrawCommand& b) {
+        if(a.layer != b.layer)
+            return a.layer < b.layer;
+        if(a.depth != b.depth)
+            return a.depth < b.depth;
+        if(a.texture != b.texture)
+            return std::less<SDL_Texture*>()(a.texture, b.texture);
+        return a.order < b.order;
+    });
+
+    // Draws of a run go to SDL at once.
+    auto sameRun = [](const DrawCommand& a, const DrawCommand& b) {
+        if(a.texture != b.texture || a.hasClip != b.hasClip)
+            return false;
+        if(a.hasClip && !SDL_RectEquals(&a.clip, &b.clip))
+            return false;
+        return a.texture != nullptr ||
+            (a.color.r == b.color.r && a.color.g == b.color.g && a.color.b == b.color.b && a.color.a == b.color.a);
+    };
+
+    SDL_Texture* bound = nullptr;
+    size_t start = 0;
+    while(start < commands.size())
+    {
+        const DrawCommand& command = commands[start];
+        size_t end = start + 1;
+        bool allDst = command.hasDst;
+        while(end < commands.size() && sameRun(command, commands[end]))
+            allDst &= commands[end++].hasDst;
+
+        Batch batch = Batch();
+        batch.texture = command.texture;
+        batch.color = command.color;
+        batch.clip = command.clip;
+        batch.hasClip = command.hasClip;
+        batch.firstCommand = start;
+        batch.commandCount = end - start;
+
+        if(command.texture == nullptr)
+        {
+            batch.type = Batch::RECTANGLES;
+            batch.first = frame.rects.size();
+            for(size_t i = start ; i < end ; ++i)
+                frame.rects.push_back(commands[i].dst);
+            batch.count = end - start;
+        }
+    #if SDL_VERSION_ATLEAST(2, 0, 18)
+        else if(end - start > 1 && allDst)
+        {
+            // Two triangles per draw, all in a single call.
+            batch.type = Batch::GEOMETRY;
+            batch.first = frame.vertices.size();
+            batch.firstIndex = frame.indices.size();
+            for(size_t i = start ; i < end ; ++i)
+            {
+                const DrawCommand& quad = commands[i];
+                SDL_Color white = { 255, 255, 255, quad.alpha };
+                float x0 = quad.dst.x;
+                float y0 = quad.dst.y;
+                float x1 = quad.dst.x + quad.dst.w;
+                float y1 = quad.dst.y + quad.dst.h;
+
+                int base = frame.vertices.size() - batch.first;
+                frame.vertices.push_back({ { x0, y0 }, white, { quad.u0, quad.v0 } });
+                frame.vertices.push_back({ { x1, y0 }, white, { quad.u1, quad.v0 } });
+                frame.vertices.push_back({ { x1, y1 }, white, { quad.u1, quad.v1 } });
+                frame.vertices.push_back({ { x0, y1 }, white, { quad.u0, quad.v1 } });
+                for(int corner : { 0, 1, 2, 0, 2, 3 })
+                    frame.indices.push_back(base + corner);
+            }
+            batch.count = frame.vertices.size() - batch.first;
+            batch.indexCount = frame.indices.size() - batch.firstIndex;
+        }
+    #endif
+        else
+            batch.type = Batch::COPIES;
+
+        if(command.texture != nullptr && command.texture != bound)
+        {
+            ++frame.stats.textureSwitches;
+            bound = command.texture;
+        }
+        frame.stats.drawCalls += batch.type == Batch::COPIES ? batch.commandCount : 1;
+        frame.batches.push_back(batch);
+        start = end;
+    }
+}
+
+void Renderer::reserve(Frame& frame, size_t commands)
+{
+    // Quads take 4 vertices and 6 indices.
+    frame.commands.reserve(commands);
+    frame.batches.reserve(commands);
+    frame.rects.reserve(commands);
+    frame.vertices.reserve(commands * 4);
+    frame.indices.reserve(commands * 6);
+}
+
+bool Renderer::submit(Frame& frame)
+{
+    bool ok = true;
+    bool clipSet = false;
+    SDL_Rect clip = { 0, 0, 0, 0 };
+    for(const Batch& batch : frame.batches)
+    {
+        // Purged batch of a destroyed texture.
+        if(batch.commandCount == 0)
+            continue;
+
+        if(batch.hasClip != clipSet || (clipSet && !SDL_RectEquals(&clip, &batch.clip)))
+        {
+            if(SDL_RenderSetClipRect(_renderer, batch.hasClip ? &batch.clip : nullptr) == -1)
+            {
+                logError("[Renderer] Failed to set clipping rectangle.");
+                ok = false;
+            }
+            clipSet = batch.hasClip;
+            clip = batch.clip;
+        }
+
+        if(batch.type == Batch::RECTANGLES)
+        {
+            if(SDL_SetRenderDrawColor(_renderer, batch.color.r, batch.color.g, batch.color.b, batch.color.a) == -1 ||
+                SDL_RenderDrawRects(_renderer, &frame.rects[batch.first], batch.count) == -1)
+            {
+                logError("[Renderer] Failed to draw rectangles.");
+                ok = false;
+            }
+            continue;
+        }
+
+    #if SDL_VERSION_ATLEAST(2, 0, 18)
+        if(batch.type == Batch::GEOMETRY)
+        {
+            if(SDL_RenderGeometry(_renderer, batch.texture, &frame.vertices[batch.first], batch.count, &frame.indices[batch.firstIndex], batch.indexCount) == 0)
+                continue;
+            logWarning("[Renderer] Failed to render a batch, falling back to single copies.");
+            frame.stats.drawCalls += batch.commandCount;
+        }
+    #endif
+
+        for(uint32_t i = batch.firstCommand ; i < batch.firstCommand + batch.commandCount ; ++i)
+        {
+            DrawCommand& command = frame.commands[i];
+            if(!this->copy(command.texture, command.hasDst ? &command.dst : nullptr, command.hasPortion ? &command.portion : nullptr, command.alpha))
+                ok = false;
+        }
+    }
+
+    if(clipSet && SDL_RenderSetClipRect(_renderer, nullptr) == -1)
+    {
+        logError("[Renderer] Failed to disable clipping.");
+        ok = false;
+    }
+    frame.commands.clear();
+    frame.batches.clear();
+    return ok;
+}
+
+SDL_Rect* Renderer::toTarget(SDL_Rect* rect, SDL_Rect& moved)
+{
+    if(rect == nullptr || _offscreens.empty())
+        return rect;
+
+    moved = *rect;
+    moved.x -= _offscreens.back().area.x;
+    moved.y -= _offscreens.back().area.y;
+    return &moved;
+}
+
 bool Renderer::setDrawColor(SDL_Color& color)
 {
     if(SDL_SetRenderDrawColor(
@@ -212,7 +673,7 @@ SDL_Texture* Renderer::loadText(
         return nullptr;
     }
 
-    SDL_Texture* texture = surfaceToTexture(surface);
+    SDL_Texture* texture = surfaceToTexture(surface, TEXTURE_TEXT);
     if(texture == nullptr)
     {
         logError("[Renderer] Failed to create texture from image.");
@@ -223,7 +684,7 @@ SDL_Texture* Renderer::loadText(
     return texture;
 }
 
-bool Renderer::renderTexture(SDL_Texture* texture, SDL_Rect* dst, SDL_Rect* portion)
+bool Renderer::renderTexture(SDL_Texture* texture, SDL_Rect* dst, SDL_Rect* portion, uint8_t alpha)
 {
     if(texture == nullptr)
     {
@@ -231,7 +692,49 @@ bool Renderer::renderTexture(SDL_Texture* texture, SDL_Rect* dst, SDL_Rect* port
         return false;
     }
 
-    if(SDL_RenderCopy(_renderer, texture, portion, dst) == -1)
+    SDL_Rect moved;
+    SDL_Rect* target = this->toTarget(dst, moved);
+
+    DrawCommand command = DrawCommand();
+    command.layer = _layer;
+    command.depth = _depth;
+    command.texture = texture;
+    command.alpha = alpha;
+    command.hasDst = target != nullptr;
+    if(command.hasDst)
+        command.dst = *target;
+    command.u1 = 1;
+    command.v1 = 1;
+    command.hasPortion = portion != nullptr;
+    if(command.hasPortion)
+    {
+        // Texture size is only known here, the worker must not ask SDL.
+        command.portion = *portion;
+        int width = 0;
+        int height = 0;
+        if(SDL_QueryTexture(texture, nullptr, nullptr, &width, &height) == 0 && width > 0 && height > 0)
+        {
+            command.u0 = portion->x / (float)width;
+            command.v0 = portion->y / (float)height;
+            command.u1 = (portion->x + portion->w) / (float)width;
+            command.v1 = (portion->y + portion->h) / (float)height;
+        }
+    }
+    command.hasClip = _hasClip;
+    command.clip = _clip;
+    _commands.push_back(command);
+    return true;
+}
+
+bool Renderer::copy(SDL_Texture* texture, SDL_Rect* dst, SDL_Rect* portion, uint8_t alpha)
+{
+    // Put back right after, other draws of the texture are opaque.
+    if(alpha != 255)
+        SDL_SetTextureAlphaMod(texture, alpha);
+    bool ok = SDL_RenderCopy(_renderer, texture, portion, dst) != -1;
+    if(alpha != 255)
+        SDL_SetTextureAlphaMod(texture, 255);
+    if(!ok)
     {
         logError("[Renderer] Failed to render texture.");
         return false;
@@ -259,7 +762,8 @@ bool Renderer::cropTexture(SDL_Texture* src, SDL_Texture*& dst, SDL_Rect* rect)
         return false;
     }
 
-    dst = this->createBlankRenderTarget(rect->w, rect->h);
+    auto source = _textures.find(src);
+    dst = this->createBlankRenderTarget(rect->w, rect->h, source == _textures.end() ? TEXTURE_OTHER : source->second.category);
 
     if(dst == nullptr)
     {
@@ -276,6 +780,34 @@ bool Renderer::cropTexture(SDL_Texture* src, SDL_Texture*& dst, SDL_Rect* rect)
     return true;
 }
 
+SDL_Texture* Renderer::scaleTexture(SDL_Texture* src, int width, int height)
+{
+    if(src == nullptr)
+    {
+        logError("[Renderer] Cannot scale texture, source = nullptr.");
+        return nullptr;
+    }
+
+    auto source = _textures.find(src);
+    SDL_Texture* dst = this->createBlankRenderTarget(width, height, source == _textures.end() ? TEXTURE_OTHER : source->second.category);
+    if(dst == nullptr)
+    {
+        logError("[Renderer] Failed to create target texture.");
+        return nullptr;
+    }
+
+    // Filter when shrinking, and when drawing the copy smaller still.
+    SDL_SetTextureScaleMode(src, SDL_ScaleModeLinear);
+    SDL_SetTextureScaleMode(dst, SDL_ScaleModeLinear);
+    if(!this->renderToTexture(src, dst, nullptr))
+    {
+        logError("[Renderer] Failed to scale texture.");
+        this->destroyTexture(dst);
+        return nullptr;
+    }
+    return dst;
+}
+
 bool Renderer::getScreenSize()
 {
     SDL_DisplayMode mode = SDL_DisplayMode();
@@ -289,7 +821,7 @@ bool Renderer::getScreenSize()
     return true;
 }
 
-SDL_Texture* Renderer::surfaceToTexture(SDL_Surface* surface)
+SDL_Texture* Renderer::surfaceToTexture(SDL_Surface* surface, TextureCategory category)
 {
     if(surface == nullptr)
     {
@@ -305,6 +837,7 @@ SDL_Texture* Renderer::surfaceToTexture(SDL_Surface* surface)
     }
 
     SDL_FreeSurface(surface);
+    this->registerTexture(texture, category);
     return texture;
 }
 
@@ -320,7 +853,8 @@ bool Renderer::renderToTexture(SDL_Texture* src, SDL_Texture* dst, SDL_Rect* dst
         return false;
     }
 
-    if(this->renderTexture(src, nullptr, dstRect) == false)
+    // Straight to SDL, the result is needed right away.
+    if(!this->copy(src, nullptr, dstRect))
     {
         logError("[Renderer] Failed to render texture to target texture.");
         return false;
@@ -336,41 +870,184 @@ bool Renderer::renderToTexture(SDL_Texture* src, SDL_Texture* dst, SDL_Rect* dst
     return true;
 }
 
-SDL_Texture* Renderer::createBlankRenderTarget(int width, int height)
+SDL_Texture* Renderer::createBlankRenderTarget(int width, int height, TextureCategory category)
 {
-    return SDL_CreateTexture(_renderer, SDL_GetWindowPixelFormat(_window), SDL_TEXTUREACCESS_TARGET, width, height);
+    SDL_Texture* texture = SDL_CreateTexture(_renderer, SDL_GetWindowPixelFormat(_window), SDL_TEXTUREACCESS_TARGET, width, height);
+    if(texture != nullptr)
+        this->registerTexture(texture, category);
+    return texture;
 }
 
-bool Renderer::drawRectangle(SDL_Rect* rect, SDL_Color color, bool restoreTexture)
+void Renderer::destroyTexture(SDL_Texture* texture)
 {
-    if(rect == nullptr)
+    // Once stopped, SDL already freed every texture with the renderer.
+    if(texture == nullptr || _renderer == nullptr)
+        return;
+
+    auto search = _textures.find(texture);
+    if(search != _textures.end())
     {
-        logError("[Renderer] drawRectangle : rect = nullptr.");
-        return false;
+        this->accountTexture(search->second, false);
+        _textures.erase(search);
     }
 
-    SDL_Color colorBackup;
-    if(restoreTexture && SDL_GetRenderDrawColor(_renderer, &(colorBackup.r), &(colorBackup.g), &(colorBackup.b), &(colorBackup.a)) == -1)
+    // Frames waiting to be presented may still draw it, pipelined
+    // the frame being recorded is presented by the second refresh().
+    _destroyed.push_back({ texture, _frameIndex + 2 });
+}
+
+void Renderer::releaseTextures(uint64_t frame)
+{
+    size_t kept = 0;
+    for(const std::pair<SDL_Texture*, uint64_t>& destroyed : _destroyed)
     {
-        logWarning("[Renderer] drawRectangle : Failed to backup current drawing color, will not restore it.");
+        if(destroyed.second <= frame)
+            SDL_DestroyTexture(destroyed.first);
+        else
+            _destroyed[kept++] = destroyed;
     }
+    _destroyed.resize(kept);
+}
+
+
+//===============
+// Texture memory
+//===============
+
+void Renderer::registerTexture(SDL_Texture* texture, TextureCategory category)
+{
+    TextureInfo info = TextureInfo();
+    info.category = category;
+    info.lastUsed = _frameIndex;
+    SDL_QueryTexture(texture, &info.format, nullptr, &info.width, &info.height);
 
-    if(SDL_SetRenderDrawColor(_renderer, color.r, color.g, color.b, color.a) == -1)
+    // Drivers may pad or convert, this is a lower bound.
+    size_t pixelBytes = SDL_BYTESPERPIXEL(info.format);
+    if(pixelBytes == 0 || SDL_ISPIXELFORMAT_FOURCC(info.format))
+        pixelBytes = 4;
+    info.bytes = pixelBytes * info.width * info.height;
+
+    this->accountTexture(info, true);
+    _textures[texture] = info;
+    this->enforceTextureBudget();
+}
+
+void Renderer::accountTexture(const TextureInfo& info, bool added)
+{
+    for(TextureMemory* memory : { &_textureMemory[info.category], &_totalTextureMemory })
     {
-        logWarning("[Renderer] drawRectangle : Failed to set drawing color.");
+        if(added)
+        {
+            ++memory->textures;
+            memory->bytes += info.bytes;
+            memory->peakBytes = std::max(memory->peakBytes, memory->bytes);
+        }
+        else
+        {
+            --memory->textures;
+            memory->bytes -= info.bytes;
+        }
     }
+}
 
-    bool ok = true;
-    if(SDL_RenderDrawRect(_renderer, rect) == -1)
+void Renderer::setTextureCategory(SDL_Texture* texture, TextureCategory category)
+{
+    auto search = _textures.find(texture);
+    if(search == _textures.end())
     {
-        logError("[Renderer] drawRectangle : Failed to render rectangle.");
-        ok = false;
+        logError("[Renderer] Cannot set texture category, texture not created by this renderer.");
+        return;
+    }
+
+    this->accountTexture(search->second, false);
+    search->second.category = category;
+    this->accountTexture(search->second, true);
+}
+
+void Renderer::setTextureBudget(size_t bytes)
+{
+    _textureBudget = bytes;
+    _overBudget = false;
+    logInfo("[Renderer] Texture budget set to " + std::to_string(bytes / 1024) + " kB.");
+    this->enforceTextureBudget();
+}
+
+void Renderer::setEvictable(SDL_Texture* texture, std::function<void()> onEvict)
+{
+    auto search = _textures.find(texture);
+    if(search == _textures.end())
+    {
+        logError("[Renderer] Cannot make texture evictable, texture not created by this renderer.");
+        return;
     }
+    search->second.onEvict = onEvict;
+    search->second.lastUsed = _frameIndex;
+}
 
-    if(restoreTexture && SDL_SetRenderDrawColor(_renderer, colorBackup.r, colorBackup.g, colorBackup.b, colorBackup.a) == -1)
+void Renderer::touchTexture(SDL_Texture* texture)
+{
+    auto search = _textures.find(texture);
+    if(search != _textures.end())
+        search->second.lastUsed = _frameIndex;
+}
+
+void Renderer::enforceTextureBudget()
+{
+    if(_textureBudget == 0)
+        return;
+
+    while(_totalTextureMemory.bytes > _textureBudget)
     {
-        logWarning("[Renderer] drawRectangle : Failed to restore drawing color.");
+        // Least recently used first, never one drawn this frame
+        // nor in the previous one, which may still be waiting to be submitted.
+        SDL_Texture* victim = nullptr;
+        uint64_t oldest = _frameIndex > 0 ? _frameIndex - 1 : 0;
+        for(const auto& entry : _textures)
+        {
+            if(entry.second.onEvict && entry.second.lastUsed < oldest)
+            {
+                victim = entry.first;
+                oldest = entry.second.lastUsed;
+            }
+        }
+
+        if(victim == nullptr)
+        {
+            if(!_overBudget)
+            {
+                logWarning("[Renderer] Texture memory " + std::to_string(_totalTextureMemory.bytes / 1024) +
+                    " kB over the budget of " + std::to_string(_textureBudget / 1024) + " kB, nothing left to evict.");
+                _overBudget = true;
+            }
+            return;
+        }
+
+        std::function<void()> onEvict = _textures[victim].onEvict;
+        logInfo("[Renderer] Evicting a texture of " + std::to_string(_textures[victim].bytes / 1024) + " kB.");
+        this->destroyTexture(victim);
+        onEvict();
     }
+    _overBudget = false;
+}
 
-    return ok;
+bool Renderer::drawRectangle(SDL_Rect* rect, SDL_Color color, Layer layer)
+{
+    if(rect == nullptr)
+    {
+        logError("[Renderer] drawRectangle : rect = nullptr.");
+        return false;
+    }
+
+    SDL_Rect moved;
+    DrawCommand command = DrawCommand();
+    command.layer = layer;
+    command.depth = 0;
+    command.texture = nullptr;
+    command.dst = *this->toTarget(rect, moved);
+    command.hasDst = true;
+    command.color = color;
+    command.hasClip = _hasClip;
+    command.clip = _clip;
+    _commands.push_back(command);
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,515 @@
+#include "Simulator.hpp"
+#include "ThreadPool.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    const uint64_t gamesPerTask = 1000;
+
+    /**
+     * Simulated player, with a fixed size memory of the revealed cards.
+     */
+    class Agent
+    {
+        public:
+
+        void reset(PlayerModel model, uint32_t cards)
+        {
+            _model = model;
+            _clock = 0;
+            _count = 0;
+            _cards = cards;
+            std::fill(_seenAt, _seenAt + cards, 0);
+        }
+
+        /**
+         * @brief Maybe remember a revealed card.
+         */
+        template<class R>
+        void see(uint32_t card, R& random)
+        {
+            ++_clock;
+            if(_seenAt[card] != 0)
+            {
+                _seenAt[card] = _clock;
+                return;
+            }
+
+            if(_model.capacity == 0 || std::uniform_real_distribution<double>(0, 1)(random) >= _model.recall)
+                return;
+
+            if(_count >= _model.capacity)
+                this->forgetOldest();
+
+            _seenAt[card] = _clock;
+            ++_count;
+        }
+
+        void forget(uint32_t card)
+        {
+            if(_seenAt[card] == 0)
+                return;
+            _seenAt[card] = 0;
+            --_count;
+        }
+
+        /**
+         * @brief Pick a remembered pair if any.
+         * Keys are expected below the pair count.
+         */
+        template<class R>
+        uint32_t pickFirst(const GameState& game, R& random)
+        {
+            int16_t byKey[GameState::maxCards];
+            std::fill(byKey, byKey + game.getCards(), -1);
+
+            for(uint32_t i = 0 ; i < game.getCards() ; ++i)
+            {
+                if(_seenAt[i] == 0 || !game.canPick(i))
+                    continue;
+                uint32_t key = game.getKey(i);
+                if(byKey[key] >= 0)
+                    return i;
+                byKey[key] = i;
+            }
+            return this->pickUnknown(game, random);
+        }
+
+        template<class R>
+        uint32_t pickSecond(const GameState& game, uint32_t first, R& random)
+        {
+            uint32_t key = game.getKey(first);
+            for(uint32_t i = 0 ; i < game.getCards() ; ++i)
+            {
+                if(_seenAt[i] != 0 && game.canPick(i) && game.getKey(i) == key)
+                    return i;
+            }
+            return this->pickUnknown(game, random);
+        }
+
+        private:
+
+        /**
+         * @brief Pick a random card not remembered,
+         * or any card if every card is remembered.
+         */
+        template<class R>
+        uint32_t pickUnknown(const GameState& game, R& random)
+        {
+            uint16_t unknown[GameState::maxCards];
+            uint16_t any[GameState::maxCards];
+            uint32_t unknownCount = 0;
+            uint32_t anyCount = 0;
+            for(uint32_t i = 0 ; i < game.getCards() ; ++i)
+            {
+                if(!game.canPick(i))
+                    continue;
+                any[anyCount++] = i;
+                if(_seenAt[i] == 0)
+                    unknown[unknownCount++] = i;
+            }
+
+            if(unknownCount > 0)
+                return unknown[random() % unknownCount];
+            return any[random() % anyCount];
+        }
+
+        void forgetOldest()
+        {
+            uint32_t oldest = 0;
+            for(uint32_t i = 1 ; i < _cards ; ++i)
+            {
+                if(_seenAt[i] != 0 && (_seenAt[oldest] == 0 || _seenAt[i] < _seenAt[oldest]))
+                    oldest = i;
+            }
+            this->forget(oldest);
+        }
+
+        PlayerModel _model;
+        uint32_t _clock = 0;
+        uint32_t _count = 0;
+        uint32_t _cards = 0;
+
+        /**
+         * @brief Clock value when each card was last seen, 0 if unknown.
+         */
+        uint32_t _seenAt[GameState::maxCards];
+    };
+
+    uint64_t splitMix(uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    bool parseNumber(std::string text, uint64_t& value)
+    {
+        try
+        {
+            size_t end = 0;
+            value = std::stoull(text, &end);
+            return end == text.size();
+        }
+        catch(const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    /**
+     * @brief Split a comma separated list.
+     */
+    std::vector<std::string> split(std::string text)
+    {
+        std::vector<std::string> parts;
+        std::stringstream stream(text);
+        std::string part;
+        while(std::getline(stream, part, ','))
+            parts.push_back(part);
+        return parts;
+    }
+
+    void usage()
+    {
+        std::cerr << "Usage : memory --simulate [options]" << std::endl
+            << "  --games N        games per pair count (default 10000)" << std::endl
+            << "  --players N      players per game (default 1)" << std::endl
+            << "  --min-pairs N    first pair count of the sweep (default 2)" << std::endl
+            << "  --max-pairs N    last pair count of the sweep (default " << GameState::deckPairs << ")" << std::endl
+            << "  --threads N      worker threads, 0 for every core (default 0)" << std::endl
+            << "  --seed N         base seed (default 0)" << std::endl
+            << "  --recall R,...   recall probability of each player (default 1)" << std::endl
+            << "  --capacity N,... cards remembered by each player (default " << GameState::maxCards << ")" << std::endl
+            << "  --histogram      also output turns histograms as CSV" << std::endl;
+    }
+}
+
+
+//====================
+// Result
+//====================
+
+double Simulator::Result::meanTurns() const
+{
+    if(games == 0)
+        return 0;
+
+    double sum = 0;
+    for(size_t i = 0 ; i < turns.size() ; ++i)
+        sum += (double)i * turns[i];
+    return sum / games;
+}
+
+uint32_t Simulator::Result::percentileTurns(double ratio) const
+{
+    uint64_t target = std::max<uint64_t>(1, std::ceil(ratio * games));
+    uint64_t count = 0;
+    for(size_t i = 0 ; i < turns.size() ; ++i)
+    {
+        count += turns[i];
+        if(count >= target)
+            return i;
+    }
+    return turns.empty() ? 0 : turns.size() - 1;
+}
+
+void Simulator::Result::merge(const Result& other)
+{
+    games += other.games;
+    ties += other.ties;
+
+    if(turns.size() < other.turns.size())
+        turns.resize(other.turns.size(), 0);
+    for(size_t i = 0 ; i < other.turns.size() ; ++i)
+        turns[i] += other.turns[i];
+
+    if(wins.size() < other.wins.size())
+        wins.resize(other.wins.size(), 0);
+    for(size_t i = 0 ; i < other.wins.size() ; ++i)
+        wins[i] += other.wins[i];
+}
+
+
+//====================
+// Simulator
+//====================
+
+Simulator::Simulator(Options options) : _options(options)
+{
+    if(_options.models.empty())
+        _options.models.push_back(PlayerModel());
+}
+
+Simulator::~Simulator() {}
+
+std::vector<Simulator::Result> Simulator::run()
+{
+    struct Task
+    {
+        uint32_t pairs;
+        uint64_t games;
+        uint64_t seed;
+    };
+
+    std::vector<Task> tasks;
+    for(uint32_t pairs = _options.minPairs ; pairs <= _options.maxPairs ; ++pairs)
+    {
+        for(uint64_t done = 0, chunk = 0 ; done < _options.games ; done += gamesPerTask, ++chunk)
+        {
+            uint64_t games = std::min(gamesPerTask, _options.games - done);
+            uint64_t seed = splitMix(_options.seed ^ splitMix(((uint64_t)pairs << 32) | chunk));
+            tasks.push_back({ pairs, games, seed });
+        }
+    }
+
+    // Each task writes its own result, merged once every task is done.
+    std::vector<Result> partials(tasks.size());
+    {
+        ThreadPool pool(_options.threads);
+        logInfo("[Simulator] Running " + std::to_string(tasks.size()) + " tasks on " + std::to_string(pool.size()) + " threads.");
+
+        // Largest boards first so that the longest tasks do not end the run alone.
+        for(size_t i = tasks.size() ; i-- > 0 ;)
+        {
+            pool.submit([this, &tasks, &partials, i] {
+                this->playGames(tasks[i].pairs, tasks[i].games, tasks[i].seed, partials[i]);
+            });
+        }
+        pool.wait();
+    }
+
+    std::vector<Result> results;
+    for(size_t i = 0 ; i < tasks.size() ; ++i)
+    {
+        if(results.empty() || results.back().pairs != tasks[i].pairs)
+        {
+            results.push_back(Result());
+            results.back().pairs = tasks[i].pairs;
+        }
+        results.back().merge(partials[i]);
+    }
+    return results;
+}
+
+void Simulator::playGames(uint32_t pairs, uint64_t games, uint64_t seed, Result& result)
+{
+    Random random(seed);
+    uint32_t players = _options.players;
+
+    Agent agents[GameState::maxPlayers];
+    uint32_t deck[GameState::maxCards];
+    GameState game;
+
+    result.pairs = pairs;
+    result.wins.assign(players, 0);
+
+    for(uint64_t n = 0 ; n < games ; ++n)
+    {
+        game.reset(players, pairs);
+
+        // Shuffled deal, the key of a pair is its index.
+        for(uint32_t i = 0 ; i < pairs * 2 ; ++i)
+            deck[i] = i / 2;
+        std::shuffle(deck, deck + pairs * 2, random);
+        for(uint32_t i = 0 ; i < pairs * 2 ; ++i)
+            game.addCard(deck[i]);
+
+        for(uint32_t i = 0 ; i < players ; ++i)
+            agents[i].reset(_options.models[std::min<size_t>(i, _options.models.size() - 1)], pairs * 2);
+
+        while(!game.isOver())
+        {
+            Agent& agent = agents[game.getActivePlayer()];
+
+            uint32_t first = agent.pickFirst(game, random);
+            game.step(GameAction::pick(first));
+            for(uint32_t i = 0 ; i < players ; ++i)
+                agents[i].see(first, random);
+
+            uint32_t second = agent.pickSecond(game, first, random);
+            game.step(GameAction::pick(second));
+            for(uint32_t i = 0 ; i < players ; ++i)
+                agents[i].see(second, random);
+
+            if(game.getPhase() == GameState::PAIR_FOUND)
+            {
+                for(uint32_t i = 0 ; i < players ; ++i)
+                {
+                    agents[i].forget(first);
+                    agents[i].forget(second);
+                }
+            }
+            game.step(GameAction::acknowledge());
+        }
+
+        uint32_t turns = game.getTurns();
+        if(result.turns.size() <= turns)
+            result.turns.resize(turns + 1, 0);
+        ++result.turns[turns];
+        ++result.games;
+
+        uint32_t best = 0;
+        uint32_t bestCount = 0;
+        for(uint32_t i = 0 ; i < players ; ++i)
+        {
+            if(game.getScore(i) > game.getScore(best))
+            {
+                best = i;
+                bestCount = 1;
+            }
+            else if(game.getScore(i) == game.getScore(best))
+                ++bestCount;
+        }
+        if(bestCount > 1)
+            ++result.ties;
+        else
+            ++result.wins[best];
+    }
+}
+
+void Simulator::print(const std::vector<Result>& results, std::ostream& out)
+{
+    out << std::setw(6) << "pairs" << std::setw(10) << "games"
+        << std::setw(9) << "mean" << std::setw(6) << "min"
+        << std::setw(6) << "p10" << std::setw(6) << "p50"
+        << std::setw(6) << "p90" << std::setw(6) << "max";
+    for(uint32_t i = 0 ; i < _options.players ; ++i)
+        out << std::setw(8) << ("win" + std::to_string(i + 1));
+    out << std::setw(8) << "ties" << std::endl;
+
+    out << std::fixed;
+    for(const Result& r : results)
+    {
+        out << std::setw(6) << r.pairs << std::setw(10) << r.games
+            << std::setw(9) << std::setprecision(2) << r.meanTurns()
+            << std::setw(6) << r.percentileTurns(0) << std::setw(6) << r.percentileTurns(0.1)
+            << std::setw(6) << r.percentileTurns(0.5) << std::setw(6) << r.percentileTurns(0.9)
+            << std::setw(6) << r.percentileTurns(1);
+        for(uint64_t w : r.wins)
+            out << std::setw(7) << std::setprecision(1) << 100.0 * w / r.games << "%";
+        out << std::setw(7) << std::setprecision(1) << 100.0 * r.ties / r.games << "%" << std::endl;
+    }
+
+    if(_options.histogram)
+    {
+        out << std::endl << "pairs,turns,games" << std::endl;
+        for(const Result& r : results)
+        {
+            for(size_t i = 0 ; i < r.turns.size() ; ++i)
+            {
+                if(r.turns[i] != 0)
+                    out << r.pairs << "," << i << "," << r.turns[i] << std::endl;
+            }
+        }
+    }
+}
+
+bool Simulator::parseArguments(std::vector<std::string> args, Options& options)
+{
+    for(size_t i = 0 ; i < args.size() ; ++i)
+    {
+        std::string arg = args[i];
+        if(arg == "--histogram")
+        {
+            options.histogram = true;
+            continue;
+        }
+
+        if(i + 1 >= args.size())
+        {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = args[++i];
+        uint64_t number = 0;
+
+        if(arg == "--recall" || arg == "--capacity")
+        {
+            std::vector<std::string> parts = split(value);
+            if(options.models.size() < parts.size())
+                options.models.resize(parts.size());
+            for(size_t j = 0 ; j < parts.size() ; ++j)
+            {
+                if(arg == "--recall")
+                {
+                    try { options.models[j].recall = std::stod(parts[j]); }
+                    catch(const std::exception&) { std::cerr << "Invalid recall " << parts[j] << std::endl; return false; }
+                }
+                else if(!parseNumber(parts[j], number))
+                {
+                    std::cerr << "Invalid capacity " << parts[j] << std::endl;
+                    return false;
+                }
+                else
+                    options.models[j].capacity = number;
+            }
+            continue;
+        }
+
+        if(!parseNumber(value, number))
+        {
+            std::cerr << "Invalid value " << value << " for " << arg << std::endl;
+            return false;
+        }
+
+        if(arg == "--games") options.games = number;
+        else if(arg == "--players") options.players = number;
+        else if(arg == "--min-pairs") options.minPairs = number;
+        else if(arg == "--max-pairs") options.maxPairs = number;
+        else if(arg == "--threads") options.threads = number;
+        else if(arg == "--seed") options.seed = number;
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if(options.players == 0 || options.players > GameState::maxPlayers)
+    {
+        std::cerr << "Players must be between 1 and " << GameState::maxPlayers << std::endl;
+        return false;
+    }
+
+    if(options.minPairs == 0 || options.minPairs > options.maxPairs || options.maxPairs > GameState::maxPairs)
+    {
+        std::cerr << "Pairs must satisfy 1 <= min <= max <= " << GameState::maxPairs << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int Simulator::main(std::vector<std::string> args)
+{
+    Options options;
+    if(!parseArguments(args, options))
+    {
+        usage();
+        return 1;
+    }
+
+    Simulator simulator(options);
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<Result> results = simulator.run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    simulator.print(results, std::cout);
+
+    uint64_t games = 0;
+    for(const Result& r : results)
+        games += r.games;
+    std::cout << std::endl << games << " games in " << std::setprecision(2) << seconds << " s ("
+        << std::setprecision(0) << games / seconds << " games/s)" << std::endl;
+    return 0;
+}
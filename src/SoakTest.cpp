@@ -0,0 +1,378 @@
+#include "SoakTest.hpp"
+#include "Clock.hpp"
+#include "Logger.hpp"
+
+#include <fstream>
+#include <iostream>
+
+#ifndef WINDOWS
+#include <unistd.h>
+#endif
+
+SoakTest::SoakTest(Renderer* renderer, Memory* memory, Options options) :
+    _renderer(renderer),
+    _memory(memory),
+    _options(options),
+    _random(options.seed)
+{
+    std::ofstream file(_options.output, std::ios::out | std::ios::trunc);
+    if(!file.is_open())
+        logError("[SoakTest] Failed to open " + _options.output + " for writing.");
+    else
+        file << "seconds,games,frames,mean_frame_ms,max_frame_ms,nodes,textures,texture_kb,rss_kb,draw_calls,texture_switches" << std::endl;
+    logInfo("[SoakTest] Soak test started.");
+}
+
+SoakTest::~SoakTest() {}
+
+
+//====================
+// Bot
+//====================
+
+void SoakTest::frame()
+{
+    uint64_t now = Clock::now();
+    if(_start == 0)
+        _start = now;
+    if(_lastFrame != 0)
+    {
+        double ms = Clock::toMilliseconds(now - _lastFrame);
+        _frameMsSum += ms;
+        if(ms > _frameMsMax)
+            _frameMsMax = ms;
+        Renderer::FrameStats stats = _renderer->getFrameStats();
+        _drawCallsSum += stats.drawCalls;
+        _textureSwitchesSum += stats.textureSwitches;
+        ++_frames;
+    }
+    _lastFrame = now;
+
+    if(_done)
+        return;
+
+    if(_clickPending)
+    {
+        this->injectClick(_target);
+        _clickPending = false;
+        return;
+    }
+
+    double seconds = (now - _start) / 1000000.0;
+    if(_failed ||
+        (_options.duration > 0 && seconds >= _options.duration) ||
+        (_options.games > 0 && _games >= _options.games))
+    {
+        _done = true;
+        this->injectQuit();
+        return;
+    }
+
+    // Move on the target first so that the hovered node
+    // is updated by Memory::update(), then click next frame.
+    if(this->chooseTarget(_target))
+    {
+        this->injectMotion(_target);
+        _clickPending = true;
+    }
+}
+
+bool SoakTest::chooseTarget(SDL_Point& target)
+{
+    if(_memory->findChild("game_menu") != nullptr)
+    {
+        _inGame = true;
+        return this->chooseCardTarget(target);
+    }
+
+    if(_inGame)
+    {
+        _inGame = false;
+        ++_games;
+        this->sample();
+    }
+    return this->chooseMenuTarget(target);
+}
+
+bool SoakTest::chooseMenuTarget(SDL_Point& target)
+{
+    static const std::vector<std::string> settings = {
+        "button_one_player", "button_two_players",
+        "button_inc_pairs", "button_inc_pairs_10",
+        "button_dec_pairs", "button_dec_pairs_10"
+    };
+
+    if(_menuClicks < 0)
+        _menuClicks = _random() % 7;
+
+    if(_menuClicks == 0)
+    {
+        _menuClicks = -1;
+        return this->nodeCenter("button_start", target);
+    }
+
+    --_menuClicks;
+    for(int tries = 0 ; tries < 10 ; ++tries)
+    {
+        if(this->nodeCenter(settings[_random() % settings.size()], target))
+            return true;
+    }
+    return false;
+}
+
+bool SoakTest::chooseCardTarget(SDL_Point& target)
+{
+    Board* board = (Board*)_memory->findChild("board");
+    if(board == nullptr)
+        return false;
+
+    CardStore* store = board->getStore();
+    if(store->size() > 0 && store->remaining() == 0)
+        return this->nodeCenter("button_new_game", target);
+
+    int revealed = -1;
+    int revealedCount = 0;
+    std::vector<size_t> hidden;
+    for(size_t i = 0 ; i < store->size() ; ++i)
+    {
+        if(store->isRemoved(i))
+            continue;
+        if(store->isRevealed(i))
+        {
+            revealed = i;
+            ++revealedCount;
+        }
+        else
+            hidden.push_back(i);
+    }
+
+    size_t card = 0;
+    if(revealedCount >= 2 || hidden.empty())
+    {
+        // Board is clickable anywhere, any revealed card will do.
+        if(revealed < 0)
+            return false;
+        card = revealed;
+    }
+    else
+    {
+        card = hidden[_random() % hidden.size()];
+
+        // Find the pair half of the time.
+        if(revealedCount == 1 && _random() % 2 == 0)
+        {
+            for(size_t i : hidden)
+            {
+                if(store->getKey(i) == store->getKey(revealed))
+                    card = i;
+            }
+        }
+    }
+
+    SDL_Rect rect = board->boardToScreen(store->getRect(card));
+    target.x = rect.x + rect.w / 2;
+    target.y = rect.y + rect.h / 2;
+    return true;
+}
+
+bool SoakTest::nodeCenter(std::string name, SDL_Point& target)
+{
+    Node* node = _memory->findChild(name, true);
+    if(node == nullptr || !node->isVisible())
+        return false;
+
+    SDL_Rect rect = node->getGlobalDestination();
+    target.x = rect.x + rect.w / 2;
+    target.y = rect.y + rect.h / 2;
+    return true;
+}
+
+void SoakTest::injectMotion(SDL_Point target)
+{
+    SDL_Event event = SDL_Event();
+    event.type = SDL_MOUSEMOTION;
+    event.motion.timestamp = SDL_GetTicks();
+    event.motion.x = target.x;
+    event.motion.y = target.y;
+    SDL_PushEvent(&event);
+}
+
+void SoakTest::injectClick(SDL_Point target)
+{
+    SDL_Event event = SDL_Event();
+    event.type = SDL_MOUSEBUTTONDOWN;
+    event.button.timestamp = SDL_GetTicks();
+    event.button.button = SDL_BUTTON_LEFT;
+    event.button.state = SDL_PRESSED;
+    event.button.clicks = 1;
+    event.button.x = target.x;
+    event.button.y = target.y;
+    SDL_PushEvent(&event);
+}
+
+void SoakTest::injectQuit()
+{
+    SDL_Event event = SDL_Event();
+    event.type = SDL_KEYDOWN;
+    event.key.timestamp = SDL_GetTicks();
+    event.key.state = SDL_PRESSED;
+    event.key.keysym.sym = SDLK_ESCAPE;
+    SDL_PushEvent(&event);
+}
+
+
+//====================
+// Measures
+//====================
+
+void SoakTest::sample()
+{
+    Sample sample;
+    sample.seconds = (_lastFrame - _start) / 1000000.0;
+    sample.games = _games;
+    sample.frames = _frames;
+    sample.meanFrameMs = _frames == 0 ? 0 : _frameMsSum / _frames;
+    sample.maxFrameMs = _frameMsMax;
+    sample.nodes = Node::getCount();
+    sample.textures = _renderer->getTextureCount();
+    sample.textureKb = _renderer->getTextureMemory().bytes / 1024;
+    sample.rssKb = readRssKb();
+    sample.meanDrawCalls = _frames == 0 ? 0 : _drawCallsSum / (double)_frames;
+    sample.meanTextureSwitches = _frames == 0 ? 0 : _textureSwitchesSum / (double)_frames;
+    _samples.push_back(sample);
+
+    _frames = 0;
+    _frameMsSum = 0;
+    _frameMsMax = 0;
+    _drawCallsSum = 0;
+    _textureSwitchesSum = 0;
+
+    std::ofstream file(_options.output, std::ios::out | std::ios::app);
+    if(file.is_open())
+    {
+        file << sample.seconds << "," << sample.games << "," << sample.frames << ","
+            << sample.meanFrameMs << "," << sample.maxFrameMs << ","
+            << sample.nodes << "," << sample.textures << "," << sample.textureKb << "," << sample.rssKb << ","
+            << sample.meanDrawCalls << "," << sample.meanTextureSwitches << std::endl;
+    }
+
+    if(_games == _options.warmup)
+    {
+        _reference = _samples.size() - 1;
+        logInfo("[SoakTest] Reference sample taken after " + std::to_string(_games) + " games.");
+    }
+    else if(_reference >= 0 && !this->check(sample))
+        _failed = true;
+}
+
+bool SoakTest::check(const Sample& sample)
+{
+    const Sample& reference = _samples[_reference];
+    std::string where = "after " + std::to_string(sample.games) + " games";
+    bool ok = true;
+
+    if(sample.nodes > reference.nodes)
+    {
+        logError("[SoakTest] Node count grew from " + std::to_string(reference.nodes) + " to " + std::to_string(sample.nodes) + " " + where + ".");
+        ok = false;
+    }
+
+    if(sample.textures > reference.textures)
+    {
+        logError("[SoakTest] Texture count grew from " + std::to_string(reference.textures) + " to " + std::to_string(sample.textures) + " " + where + ".");
+        ok = false;
+    }
+
+    if(sample.rssKb > reference.rssKb + _options.maxRssGrowth)
+    {
+        logError("[SoakTest] RSS grew from " + std::to_string(reference.rssKb) + " kB to " + std::to_string(sample.rssKb) + " kB " + where + ".");
+        ok = false;
+    }
+
+    if(reference.meanFrameMs > 0 && sample.meanFrameMs > reference.meanFrameMs * _options.maxFrameTimeGrowth)
+    {
+        logError("[SoakTest] Mean frame time grew from " + std::to_string(reference.meanFrameMs) + " ms to " + std::to_string(sample.meanFrameMs) + " ms " + where + ".");
+        ok = false;
+    }
+
+    return ok;
+}
+
+int SoakTest::finish()
+{
+    std::cout << "Soak test : " << _games << " games played, samples written to " << _options.output << std::endl;
+
+    if(_reference < 0)
+    {
+        std::cout << "Not enough games to leave the warmup, nothing was checked." << std::endl;
+        logWarning("[SoakTest] Finished before the end of the warmup.");
+        return 0;
+    }
+
+    const Sample& reference = _samples[_reference];
+    const Sample& last = _samples.back();
+    std::cout << "nodes " << reference.nodes << " -> " << last.nodes
+        << ", textures " << reference.textures << " -> " << last.textures
+        << ", rss " << reference.rssKb << " kB -> " << last.rssKb << " kB"
+        << ", mean frame " << reference.meanFrameMs << " ms -> " << last.meanFrameMs << " ms"
+        << ", draw calls " << reference.meanDrawCalls << " -> " << last.meanDrawCalls << std::endl;
+
+    if(_failed)
+    {
+        std::cout << "FAILED, see log.txt for details." << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    logInfo("[SoakTest] Soak test passed.");
+    return 0;
+}
+
+uint64_t SoakTest::readRssKb()
+{
+#ifdef WINDOWS
+    return 0;
+#else
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    if(!(statm >> size >> resident))
+        return 0;
+    return resident * sysconf(_SC_PAGESIZE) / 1024;
+#endif
+}
+
+bool SoakTest::parseArguments(std::vector<std::string> args, Options& options)
+{
+    for(size_t i = 0 ; i < args.size() ; ++i)
+    {
+        std::string arg = args[i];
+        if(i + 1 >= args.size())
+        {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = args[++i];
+
+        try
+        {
+            if(arg == "--duration") options.duration = std::stod(value);
+            else if(arg == "--games") options.games = std::stoull(value);
+            else if(arg == "--warmup") options.warmup = std::stoull(value);
+            else if(arg == "--max-rss-growth") options.maxRssGrowth = std::stoull(value);
+            else if(arg == "--max-frame-growth") options.maxFrameTimeGrowth = std::stod(value);
+            else if(arg == "--seed") options.seed = std::stoull(value);
+            else if(arg == "--output") options.output = value;
+            else
+            {
+                std::cerr << "Unknown option " << arg << std::endl;
+                return false;
+            }
+        }
+        catch(const std::exception&)
+        {
+            std::cerr << "Invalid value " << value << " for " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
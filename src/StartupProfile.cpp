@@ -0,0 +1,44 @@
+#include "StartupProfile.hpp"
+#include "Logger.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+StartupProfile::StartupProfile() :
+    _start(Clock::now()),
+    _last(_start)
+{}
+
+void StartupProfile::mark(const std::string& step)
+{
+    Clock::time_point now = Clock::now();
+    _steps.push_back({ step, (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now - _last).count() });
+    _last = now;
+}
+
+uint64_t StartupProfile::getTotal() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(_last - _start).count();
+}
+
+bool StartupProfile::log(uint32_t budgetMs) const
+{
+    uint64_t total = this->getTotal();
+    for(const Step& step : _steps)
+    {
+        std::stringstream line;
+        line << std::fixed << std::setprecision(1) << step.duration / 1000.0 << " ms ("
+            << (total == 0 ? 0 : 100.0 * step.duration / total) << " %)";
+        logInfo("[Startup] " + step.name + " : " + line.str());
+    }
+
+    std::stringstream summary;
+    summary << std::fixed << std::setprecision(1) << total / 1000.0 << " ms";
+    if(budgetMs > 0 && total > budgetMs * (uint64_t)1000)
+    {
+        logWarning("[Startup] Total : " + summary.str() + ", over the budget of " + std::to_string(budgetMs) + " ms.");
+        return false;
+    }
+    logInfo("[Startup] Total : " + summary.str() + ".");
+    return true;
+}
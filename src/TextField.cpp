@@ -15,7 +15,10 @@ TextField::TextField(Renderer* renderer, std::string name, std::string text, TTF
     this->setText(text, font);
 }
 
-TextField::~TextField() {}
+TextField::~TextField()
+{
+    _renderer->destroyTexture(_texture);
+}
 
 bool TextField::setText(
     std::string text,
@@ -77,7 +80,7 @@ bool TextField::setText(
 
     if(_texture != nullptr)
     {
-        SDL_DestroyTexture(_texture);
+        _renderer->destroyTexture(_texture);
         _texture = nullptr;
     }
     
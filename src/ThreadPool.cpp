@@ -0,0 +1,101 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    if(threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if(threads == 0)
+        threads = 1;
+
+    for(size_t i = 0 ; i < threads ; ++i)
+        _queues.push_back(std::make_unique<Queue>());
+
+    for(size_t i = 0 ; i < threads ; ++i)
+        _threads.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    this->wait();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wakeUp.notify_all();
+    for(std::thread& thread : _threads)
+        thread.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    // Count the task first so that a worker taking it
+    // never sees the counters go below zero.
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_pending;
+        ++_queued;
+    }
+
+    size_t index = _nextQueue++ % _queues.size();
+    {
+        std::lock_guard<std::mutex> lock(_queues[index]->mutex);
+        _queues[index]->tasks.push_back(std::move(task));
+    }
+    _wakeUp.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _pending == 0; });
+}
+
+void ThreadPool::work(size_t index)
+{
+    std::function<void()> task;
+    while(true)
+    {
+        if(this->pop(index, task) || this->steal(index, task))
+        {
+            --_queued;
+            task();
+            task = nullptr;
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if(--_pending == 0)
+                _done.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wakeUp.wait(lock, [this] { return _stop || _queued > 0; });
+        if(_stop && _queued == 0)
+            return;
+    }
+}
+
+bool ThreadPool::pop(size_t index, std::function<void()>& task)
+{
+    Queue& queue = *_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if(queue.tasks.empty())
+        return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t index, std::function<void()>& task)
+{
+    for(size_t i = 1 ; i < _queues.size() ; ++i)
+    {
+        Queue& queue = *_queues[(index + i) % _queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.tasks.empty())
+            continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
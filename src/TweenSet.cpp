@@ -0,0 +1,115 @@
+#include "TweenSet.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void TweenSet::reserve(size_t cards)
+{
+    this->clear();
+    _cards.reserve(cards);
+    _types.reserve(cards);
+    _elapsed.reserve(cards);
+    _durations.reserve(cards);
+    _tweenOf.assign(cards, -1);
+}
+
+void TweenSet::clear()
+{
+    _cards.clear();
+    _types.clear();
+    _elapsed.clear();
+    _durations.clear();
+    std::fill(_tweenOf.begin(), _tweenOf.end(), -1);
+    std::fill(std::begin(_running), std::end(_running), 0);
+}
+
+void TweenSet::start(uint32_t card, Type type, uint32_t duration)
+{
+    // Cards dealt past the reserved count.
+    if(card >= _tweenOf.size())
+        _tweenOf.resize(card + 1, -1);
+    duration = std::max<uint32_t>(duration, 1);
+
+    int32_t tween = _tweenOf[card];
+    if(tween < 0)
+    {
+        _tweenOf[card] = _cards.size();
+        _cards.push_back(card);
+        _types.push_back(type);
+        _elapsed.push_back(0);
+        _durations.push_back(duration);
+        ++_running[type];
+        return;
+    }
+
+    // A flip turned back at the same width shows the same face.
+    uint32_t elapsed = 0;
+    if(type == FLIP && _types[tween] == FLIP)
+        elapsed = duration - std::min(duration, (uint32_t)((uint64_t)_elapsed[tween] * duration / _durations[tween]));
+    --_running[_types[tween]];
+    ++_running[type];
+    _types[tween] = type;
+    _elapsed[tween] = elapsed;
+    _durations[tween] = duration;
+}
+
+void TweenSet::update(uint64_t elapsed, CardStore& store)
+{
+    size_t tween = 0;
+    while(tween < _cards.size())
+    {
+        _elapsed[tween] = std::min<uint64_t>(_elapsed[tween] + elapsed, _durations[tween]);
+        if(_elapsed[tween] < _durations[tween])
+        {
+            ++tween;
+            continue;
+        }
+        this->complete(tween, store);
+        this->erase(tween);
+    }
+}
+
+void TweenSet::apply(uint64_t ahead, CardStore& store)
+{
+    for(size_t tween = 0 ; tween < _cards.size() ; ++tween)
+    {
+        float progress = std::min(1.0f, (float)(_elapsed[tween] + ahead) / _durations[tween]);
+        if(_types[tween] == FLIP)
+            store.setTransform(_cards[tween], std::fabs(1 - 2 * progress), 255, progress < 0.5f);
+        else
+            store.setTransform(_cards[tween], 1, std::lround(255 * (1 - progress)), false);
+    }
+}
+
+bool TweenSet::isRunning(uint32_t card, Type type) const
+{
+    return card < _tweenOf.size() && _tweenOf[card] >= 0 && _types[_tweenOf[card]] == type;
+}
+
+void TweenSet::complete(size_t tween, CardStore& store)
+{
+    uint32_t card = _cards[tween];
+    store.setTransform(card, 1, 255, false);
+    if(_types[tween] == VANISH)
+        store.remove(card);
+}
+
+void TweenSet::erase(size_t tween)
+{
+    --_running[_types[tween]];
+    _tweenOf[_cards[tween]] = -1;
+
+    size_t last = _cards.size() - 1;
+    if(tween != last)
+    {
+        _cards[tween] = _cards[last];
+        _types[tween] = _types[last];
+        _elapsed[tween] = _elapsed[last];
+        _durations[tween] = _durations[last];
+        _tweenOf[_cards[tween]] = tween;
+    }
+    _cards.pop_back();
+    _types.pop_back();
+    _elapsed.pop_back();
+    _durations.pop_back();
+}
@@ -0,0 +1,143 @@
+#include "Watchdog.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+std::atomic<const char*> Watchdog::_zones[Watchdog::maxZones];
+std::atomic<size_t> Watchdog::_zoneDepth { 0 };
+
+Watchdog::Watchdog(Options options) :
+    _options(options),
+    _start(Clock::now())
+{
+    _thread = std::thread(&Watchdog::run, this);
+    logInfo("[Watchdog] Watching frames longer than " + std::to_string(_options.thresholdMs) + " ms.");
+}
+
+Watchdog::~Watchdog()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wakeUp.notify_one();
+    _thread.join();
+}
+
+
+//====================
+// Main thread
+//====================
+
+void Watchdog::heartbeat()
+{
+    uint64_t time = this->now();
+    uint64_t last = _lastBeat.load(std::memory_order_relaxed);
+    uint64_t frame = _frames.load(std::memory_order_relaxed);
+    if(last != 0)
+    {
+        uint64_t duration = time - last;
+        _frameTimes[frame % historySize].store(duration > UINT32_MAX ? UINT32_MAX : duration, std::memory_order_relaxed);
+        _frames.store(frame + 1, std::memory_order_relaxed);
+    }
+    _lastBeat.store(time, std::memory_order_release);
+}
+
+void Watchdog::pushZone(const char* name)
+{
+    size_t depth = _zoneDepth.load(std::memory_order_relaxed);
+    if(depth < maxZones)
+        _zones[depth].store(name, std::memory_order_relaxed);
+    _zoneDepth.store(depth + 1, std::memory_order_release);
+}
+
+void Watchdog::popZone()
+{
+    size_t depth = _zoneDepth.load(std::memory_order_relaxed);
+    if(depth > 0)
+        _zoneDepth.store(depth - 1, std::memory_order_release);
+}
+
+
+//====================
+// Watchdog thread
+//====================
+
+void Watchdog::run()
+{
+    // Checking four times per threshold catches a stall at most a quarter late.
+    std::chrono::milliseconds period(std::max<uint32_t>(_options.thresholdMs / 4, 1));
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(!_wakeUp.wait_for(lock, period, [this] { return _stop; }))
+    {
+        uint64_t last = _lastBeat.load(std::memory_order_acquire);
+        if(last == 0)
+            continue;
+
+        uint64_t stalled = (this->now() - last) / 1000;
+        uint64_t frame = _frames.load(std::memory_order_relaxed);
+        if(stalled < _options.thresholdMs || frame == _dumpedFrame)
+            continue;
+
+        _dumpedFrame = frame;
+        ++_stalls;
+        this->dump(stalled);
+        if(_options.abort)
+            std::abort();
+    }
+}
+
+void Watchdog::dump(uint64_t stalledMs)
+{
+    std::ofstream file(_options.dumpPath, std::ios::out | std::ios::app);
+    if(!file.is_open())
+    {
+        logError("[Watchdog] Failed to open " + _options.dumpPath + " to dump a stall of " + std::to_string(stalledMs) + " ms.");
+        return;
+    }
+
+    uint64_t frames = _frames.load(std::memory_order_relaxed);
+    file << "==== Stall of " << stalledMs << " ms in frame " << frames + 1
+        << ", threshold " << _options.thresholdMs << " ms" << std::endl;
+
+    // The main thread keeps running, the stack may change while read.
+    size_t depth = _zoneDepth.load(std::memory_order_acquire);
+    file << "Zones, outermost first :" << std::endl;
+    for(size_t i = 0 ; i < depth && i < maxZones ; ++i)
+    {
+        const char* zone = _zones[i].load(std::memory_order_relaxed);
+        file << "  " << (zone == nullptr ? "?" : zone) << std::endl;
+    }
+    if(depth > maxZones)
+        file << "  ... " << depth - maxZones << " more" << std::endl;
+
+    file << "Last frame times in ms, oldest first :";
+    size_t count = std::min<uint64_t>(frames, historySize);
+    for(size_t i = frames - count ; i < frames ; ++i)
+        file << " " << _frameTimes[i % historySize].load(std::memory_order_relaxed) / 1000.0;
+    file << std::endl;
+
+    std::vector<std::string> records;
+    bool logAvailable = logRecent(records);
+    if(logAvailable)
+    {
+        file << "Recent log records :" << std::endl;
+        for(const std::string& record : records)
+            file << "  " << record << std::endl;
+    }
+    else
+        file << "Recent log records unavailable, a log write is in progress." << std::endl;
+    file.close();
+
+    // Skipped if the stall is the log itself, this thread would wait for it.
+    if(logAvailable)
+        logError("[Watchdog] Frame stalled for " + std::to_string(stalledMs) + " ms, state dumped to " + _options.dumpPath + ".");
+}
+
+uint64_t Watchdog::now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - _start).count() + 1;
+}
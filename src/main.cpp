@@ -1,21 +1,132 @@
 #include <time.h>
 
+#include "AllocationCounter.hpp"
+#include "CardAtlas.hpp"
+#include "Clock.hpp"
+#include "FixedTimestep.hpp"
 #include "Logger.hpp"
 #include "Renderer.hpp"
 #include "Memory.hpp"
+#include "Simulator.hpp"
+#include "SoakTest.hpp"
+#include "StartupProfile.hpp"
+#include "Recording.hpp"
+#include "Watchdog.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
 
 int main(int argc, char*argv[])
 {
-    (void) argc;
-    (void) argv;
+    StartupProfile startup;
+    std::vector<std::string> args(argv + 1, argv + argc);
 
-    srand(time(NULL));
-    SDL_Event event;
+    // Headless modes, no window needed.
+    if(!args.empty() && args[0] == "--simulate")
+        return Simulator::main(std::vector<std::string>(args.begin() + 1, args.end()));
+
+    // Recording options can be combined with any windowed mode.
+    std::string recordPath;
+    std::string replayPath;
+    bool realtime = false;
+    size_t textureBudgetMb = 0;
+    size_t boards = 1;
+    uint32_t startupBudgetMs = 0;
+    float resolutionTargetMs = 0;
+    std::string renderDriver;
+    Watchdog::Options watchdogOptions;
+    for(size_t i = 0 ; i < args.size() ; )
+    {
+        if((args[i] == "--record" || args[i] == "--replay") && i + 1 < args.size())
+        {
+            (args[i] == "--record" ? recordPath : replayPath) = args[i + 1];
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        }
+        else if(args[i] == "--texture-budget" && i + 1 < args.size())
+        {
+            textureBudgetMb = std::strtoul(args[i + 1].c_str(), nullptr, 10);
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        }
+        else if(args[i] == "--boards" && i + 1 < args.size())
+        {
+            // Tournament tables, several games side by side in the window.
+            boards = std::strtoul(args[i + 1].c_str(), nullptr, 10);
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        }
+        else if(args[i] == "--dynamic-resolution" && i + 1 < args.size())
+        {
+            // Submit and present time to hold on weak GPUs, in milliseconds.
+            resolutionTargetMs = std::strtof(args[i + 1].c_str(), nullptr);
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        }
+        else if(args[i] == "--render-driver" && i + 1 < args.size())
+        {
+            // A driver name, "probe" to time them again, "default" to let SDL choose.
+            renderDriver = args[i + 1];
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        }
+        else if(args[i] == "--startup-budget" && i + 1 < args.size())
+        {
+            startupBudgetMs = std::strtoul(args[i + 1].c_str(), nullptr, 10);
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        }
+        else if(args[i] == "--stall-ms" && i + 1 < args.size())
+        {
+            // 0 disables the watchdog.
+            watchdogOptions.thresholdMs = std::strtoul(args[i + 1].c_str(), nullptr, 10);
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        }
+        else if(args[i] == "--stall-abort")
+        {
+            watchdogOptions.abort = true;
+            args.erase(args.begin() + i);
+        }
+        else if(args[i] == "--realtime")
+        {
+            realtime = true;
+            args.erase(args.begin() + i);
+        }
+        else
+            ++i;
+    }
+
+    bool soak = !args.empty() && args[0] == "--soak";
+    SoakTest::Options soakOptions;
+    if(soak && !SoakTest::parseArguments(std::vector<std::string>(args.begin() + 1, args.end()), soakOptions))
+        return 1;
 
     logInit();
 
+    if(boards < 1 || boards > 4)
+    {
+        logError("From 1 to 4 boards can share the window, not " + std::to_string(boards) + ".");
+        return 1;
+    }
+    if(boards > 1 && (soak || !recordPath.empty() || !replayPath.empty()))
+    {
+        logError("Soak tests, recordings and replays drive a single board.");
+        return 1;
+    }
+
+    std::unique_ptr<InputReplayer> replayer;
+    if(!replayPath.empty())
+    {
+        replayer.reset(new InputReplayer());
+        if(!replayer->open(replayPath))
+            return 1;
+    }
+
+    // Replays deal the recorded cards.
+    uint32_t seed = replayer ? replayer->getSeed() : time(NULL);
+    srand(seed);
+    SDL_Event event;
+
+    startup.mark("setup");
+
     Renderer r;
-    if(!r.init())
+    if(!r.init(&startup, renderDriver))
         return -1;
     
     TTF_Font* font = r.loadFont("res/olivier.ttf", 40);
@@ -23,6 +134,13 @@ int main(int argc, char*argv[])
         return -1;
 
     r.setDefaultFont(font);
+    startup.mark("font");
+
+    // Shared with the compositor on small GPUs, in megabytes.
+    if(textureBudgetMb > 0)
+        r.setTextureBudget(textureBudgetMb * 1024 * 1024);
+    if(resolutionTargetMs > 0 && !r.setDynamicResolution(resolutionTargetMs))
+        return -1;
 
     SDL_Texture* cardSpriteSheet = r.loadImage("res/cards.bmp");
     if(cardSpriteSheet == nullptr)
@@ -32,30 +150,216 @@ int main(int argc, char*argv[])
     if(background == nullptr)
         return -1;
 
-    Memory memory(&r, cardSpriteSheet, background);
+    // Card faces cut from the sheets inherit its category.
+    r.setTextureCategory(cardSpriteSheet, Renderer::TEXTURE_CARDS);
+    r.setTextureCategory(background, Renderer::TEXTURE_BACKGROUND);
+    startup.mark("images");
 
-    //Main loop.
-    while(!memory.getQuit())
+    if(replayer && (replayer->getWidth() != r.getWidth() || replayer->getHeight() != r.getHeight()))
     {
+        logError("Recording was made on a " + std::to_string(replayer->getWidth()) + "x" + std::to_string(replayer->getHeight()) + " screen, cannot replay it.");
+        return 1;
+    }
+
+    // Cut once, every game draws from it.
+    CardAtlas atlas(&r);
+    atlas.addFaceSet(cardSpriteSheet);
+
+    // Extra face sets for boards bigger than a deck, in name order.
+    std::vector<std::string> faceSheets;
+    if(std::filesystem::is_directory("res/faces"))
+    {
+        for(const auto& entry : std::filesystem::directory_iterator("res/faces"))
+        {
+            if(entry.path().extension() == ".bmp")
+                faceSheets.push_back(entry.path().string());
+        }
+    }
+    std::sort(faceSheets.begin(), faceSheets.end());
+    for(const std::string& path : faceSheets)
+    {
+        SDL_Texture* sheet = r.loadImage(path);
+        if(sheet == nullptr)
+            continue;
+        r.setTextureCategory(sheet, Renderer::TEXTURE_CARDS);
+        atlas.addFaceSet(sheet);
+        r.destroyTexture(sheet);
+    }
+    // Extra sheets are loaded as they are sliced.
+    startup.mark("texture slicing");
+
+    // Two games side by side, three or four in a grid.
+    // Each has its own game thread, high scores and statistics.
+    std::vector<std::unique_ptr<Memory>> games;
+    int columns = boards == 1 ? 1 : 2;
+    int rows = boards > 2 ? 2 : 1;
+    for(size_t i = 0 ; i < boards ; ++i)
+    {
+        SDL_Rect area = { 0, 0, 0, 0 };
+        if(boards > 1)
+        {
+            int width = r.getWidth() / columns;
+            int height = r.getHeight() / rows;
+            area = { (int)(i % columns) * width, (int)(i / columns) * height, width, height };
+        }
+        std::string suffix = i == 0 ? "" : "_" + std::to_string(i + 1);
+        games.emplace_back(new Memory(&r, &atlas, background, area, "high_scores" + suffix));
+    }
+    Memory& memory = *games.front();
+    startup.mark("games");
+
+    std::unique_ptr<InputRecorder> recorder;
+    if(!recordPath.empty())
+    {
+        recorder.reset(new InputRecorder());
+        if(!recorder->open(recordPath, seed, r.getWidth(), r.getHeight()))
+            return 1;
+    }
+
+    // A replay must not overwrite the player's high score,
+    // and its clicks carry the recorded clock.
+    if(replayer)
+    {
+        memory.setSaveEnabled(false);
+        memory.setLatencyTracking(false);
+    }
+
+    // Recorded games must play out the same when replayed,
+    // whatever the game thread's timing.
+    if(recorder || replayer || soak)
+        memory.setLockstep(true);
+
+    std::unique_ptr<SoakTest> soakTest;
+    if(soak)
+        soakTest.reset(new SoakTest(&r, &memory, soakOptions));
+
+    FrameAllocations allocations;
+
+    // Updates run at a fixed rate, drawing interpolates between them.
+    FixedTimestep timestep;
+
+    // Started last, loading is not a frame.
+    std::unique_ptr<Watchdog> watchdog;
+    if(watchdogOptions.thresholdMs > 0)
+        watchdog.reset(new Watchdog(watchdogOptions));
+
+    //Main loop, until every game quit.
+    bool quit = false;
+    while(!quit)
+    {
+        allocations.beginFrame();
         r.clear();
 
-        //Event loop.
-        while(SDL_PollEvent(&event) != 0)
-            memory.eventHandler(event);
+        if(replayer)
+        {
+            // Live input is ignored, the recording drives the game.
+            while(SDL_PollEvent(&event) != 0);
+            if(!replayer->frame(memory, realtime))
+                break;
+            timestep.advance(replayer->getTime());
+        }
+        else
+        {
+            // Soak tests run uncapped, an update a frame.
+            uint64_t now = soakTest ? timestep.getTime() + timestep.getStep() : Clock::now();
+            timestep.advance(now);
+            if(recorder)
+                recorder->beginFrame(now);
+
+            //Event loop, games ignore clicks outside of their area.
+            while(SDL_PollEvent(&event) != 0)
+            {
+                if(recorder)
+                    recorder->event(event);
+                for(std::unique_ptr<Memory>& game : games)
+                    game->eventHandler(event);
+            }
+        }
+
+        allocations.beginPhase(FrameAllocations::UPDATE);
+        while(timestep.step())
+        {
+            for(std::unique_ptr<Memory>& game : games)
+            {
+                if(game->getQuit())
+                    continue;
+                game->setTime(timestep.getTime());
+                game->update();
+            }
+        }
 
-        memory.update();
-        memory.render();
+        // After the updates, clicks are queued events that the bot
+        // must see handled before it picks its next target.
+        if(soakTest)
+            soakTest->frame();
+        allocations.beginPhase(FrameAllocations::RENDER);
+        bool steady = true;
+        for(std::unique_ptr<Memory>& game : games)
+        {
+            if(!game->getQuit())
+            {
+                game->interpolate(timestep.getAlpha());
+                game->render();
+            }
+            steady &= game->isSteady();
+        }
+        allocations.beginPhase(FrameAllocations::PRESENT);
         r.refresh();
-        SDL_Delay(10);
+        allocations.endFrame(steady);
+        // Pipelined, the first refresh presents an empty frame.
+        if(allocations.getFrames() == (r.isPipelined() ? 2 : 1))
+        {
+            startup.mark("first frame");
+            startup.log(startupBudgetMs);
+        }
+        if(watchdog)
+            watchdog->heartbeat();
+
+        if(recorder)
+            recorder->endFrame(memory);
+        if(replayer)
+            replayer->endFrame(memory);
+
+        // Soak tests and replays run uncapped.
+        if(!soakTest && !replayer)
+            SDL_Delay(10);
+
+        quit = true;
+        for(std::unique_ptr<Memory>& game : games)
+            quit &= game->getQuit();
     }
 
+    if(recorder)
+        recorder->close();
+
+    logInfo("Frame allocations : " + allocations.report());
+    logInfo("Peak texture memory : " + std::to_string(r.getTextureMemory().peakBytes / 1024) + " kB.");
+    if(timestep.getDropped() > 0)
+        logInfo("Slow frames left " + std::to_string(timestep.getDropped() / 1000) + " ms unsimulated.");
+
+    for(size_t i = 0 ; i < games.size() ; ++i)
+    {
+        const LatencyHistogram& latency = games[i]->getInputLatency();
+        if(latency.getCount() == 0)
+            continue;
+        std::string suffix = i == 0 ? "" : "_" + std::to_string(i + 1);
+        logInfo("Click to flip latency of board " + std::to_string(i + 1) + " : " + latency.summary() + ".");
+        latency.dump("latency" + suffix + ".txt");
+    }
+
+    int code = 0;
+    if(soakTest && soakTest->finish() != 0)
+        code = 1;
+    if(replayer && replayer->finish() != 0)
+        code = 1;
+
     //Quit SDL.
     //Destroying textures
-    SDL_DestroyTexture(background);
-    SDL_DestroyTexture(cardSpriteSheet);
+    r.destroyTexture(background);
+    r.destroyTexture(cardSpriteSheet);
     
     TTF_CloseFont(font);
 
     r.stop();
-    return 0;
+    return code;
 }